@@ -0,0 +1,58 @@
+#ifndef CSE168_ACCUMULATION_BUFFER_H_INCLUDED
+#define CSE168_ACCUMULATION_BUFFER_H_INCLUDED
+
+#include "Vector3.h"
+#include <stdio.h>
+
+/*
+    Running per-pixel sample statistics for the adaptive sampler. Each pixel
+    keeps the sum of its sample colors (for the mean) and the sum and sum of
+    squares of their luminance (for the variance), so the pixel's estimated
+    error can be checked after every pass without storing the samples.
+*/
+class AccumulationBuffer
+{
+public:
+	AccumulationBuffer();
+	~AccumulationBuffer();
+
+	void resize( int width, int height );
+	void clear();
+
+	void addSample( int x, int y, const Vector3& color );
+
+	int width() const                       {return m_width;}
+	int height() const                      {return m_height;}
+	int numSamples( int x, int y ) const    {return m_pixels[y*m_width+x].numSamples;}
+	bool isConverged( int x, int y ) const  {return m_pixels[y*m_width+x].converged;}
+	void setConverged( int x, int y )       {m_pixels[y*m_width+x].converged = true;}
+
+	Vector3 mean( int x, int y ) const;
+	// unbiased sample variance of the pixel's luminance
+	float variance( int x, int y ) const;
+	// standard error of the pixel's mean luminance, relative to that luminance.
+	// dark pixels are measured against errorFloor instead so they can converge too
+	float relativeError( int x, int y, float errorFloor ) const;
+
+	// raw dump of the statistics for checkpoints; read() expects the buffer to be sized already
+	bool write( FILE * fp ) const;
+	bool read( FILE * fp );
+
+	static float luminance( const Vector3& color ) {return 0.2126f*color.x + 0.7152f*color.y + 0.0722f*color.z;}
+
+private:
+	struct Pixel
+	{
+		Vector3 sum;
+		float lumSum;
+		float lumSqSum;
+		int numSamples;
+		bool converged;
+	};
+
+	Pixel* m_pixels;
+	int m_width;
+	int m_height;
+};
+
+#endif // CSE168_ACCUMULATION_BUFFER_H_INCLUDED
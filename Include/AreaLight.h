@@ -4,6 +4,8 @@
 #include "PointLight.h"
 #include "Scene.h"
 
+#define AREA_LIGHT_SEED 2718 // the sample points on the light are drawn with this seed
+
 class AreaLight : public PointLight
 {
 public:
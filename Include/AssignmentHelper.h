@@ -6,11 +6,13 @@
 #include "Material.h"
 #include "Matrix4x4.h"
 #include "Scene.h"
+#include "Instance.h"
 
 class AssignmentHelper
 {
 public:
 	static void addMeshTrianglesToScene(TriangleMesh * mesh, Material * material);
+	static void addMeshInstanceToScene(TriangleMesh * mesh, Material * material, const Matrix4x4 & xform);
 	static Matrix4x4 translate(float x, float y, float z);
 	static Matrix4x4 scale(float x, float y, float z);
 	static Matrix4x4 rotate(float angle, float x, float y, float z);
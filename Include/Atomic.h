@@ -0,0 +1,50 @@
+#ifndef CSE168_ATOMIC_H_INCLUDED
+#define CSE168_ATOMIC_H_INCLUDED
+
+#ifdef WIN32
+#include <intrin.h>
+#pragma intrinsic(_InterlockedExchangeAdd, _InterlockedCompareExchange)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// operations on a long that other threads can use at the same time
+
+// adds to value and returns what it was before
+inline long
+atomicAdd( volatile long * value, long amount )
+{
+#ifdef WIN32
+	return _InterlockedExchangeAdd( value, amount );
+#else
+	return __sync_fetch_and_add( value, amount );
+#endif
+}
+
+// sets value to newValue if it's expected; returns true if it was
+inline bool
+atomicCompareAndSwap( volatile long * value, long expected, long newValue )
+{
+#ifdef WIN32
+	return _InterlockedCompareExchange( value, newValue, expected ) == expected;
+#else
+	return __sync_bool_compare_and_swap( value, expected, newValue );
+#endif
+}
+
+// a lock for the rare times threads have to take turns. it spins rather than
+// sleeps, so only hold it for a moment
+class SpinLock
+{
+public:
+	SpinLock() : m_locked(0) {}
+
+	void lock()     {while( !atomicCompareAndSwap( &m_locked, 0, 1 ) ) {}}
+	void unlock()   {atomicCompareAndSwap( &m_locked, 1, 0 );}
+
+private:
+	volatile long m_locked;
+};
+
+#endif // CSE168_ATOMIC_H_INCLUDED
@@ -31,6 +31,10 @@ public:
     virtual bool intersect(HitInfo& result, const Ray& ray,
                            float tMin = 0.0f, float tMax = MIRO_TMAX);
 
+	// the patch always lies within the convex hull of its four corners
+	virtual void getBounds(Vector3& vMin, Vector3& vMax) const;
+	virtual Vector3 getMidPoint() const;
+
 protected:
     Vector3 m_verts[4];
 
@@ -2,12 +2,14 @@
 #define CSE168_BVH_H_INCLUDED
 
 #define USE_BVH 1
-#define NUM_NODE_CHILDREN 2 // don't change this
 #define NUM_LEAF_CHILDREN 4 // this can be varied for best performance
+#define SAH_TRAVERSAL_COST 1.0f // cost of visiting a node, relative to testing a primitive (for sahCost())
 
 #include "Miro.h"
 #include "Object.h"
+#include "TriangleMesh.h"
 #include "BoundingVolume.h"
+#include "MemoryArena.h"
 
 class BVH
 {
@@ -15,30 +17,50 @@ public:
 	BVH();
 	virtual ~BVH();
 
-    void build(Objects * objs);
+	// the hierarchy holds generic objects and, without any per-triangle objects,
+	// every triangle of each mesh. it doesn't take ownership of either.
+    void build(Objects * objs, TriangleMeshes * meshes = NULL);
 
 	void renderGL();
     bool intersect(HitInfo& result, const Ray& ray,
                    float tMin = 0.0f, float tMax = MIRO_TMAX) const;
 
+	// bounds of everything in the hierarchy
+	void getBounds( Vector3 &min, Vector3 &max ) const;
+
 	int numNodes()	{ return m_numNodes; }
 	int numLeaves()	{ return m_numLeaves; }
 
-	static void intersectBoundingVolume()	{ BVIntersections++; }
-	static void intersectPrimitive()		{ PrimIntersections++; }
-	static void resetIntersections()		{ BVIntersections = 0; PrimIntersections = 0; }
+	// the surface area heuristic's estimate of what a ray that hits the root
+	// costs, in primitive tests: each node costs SAH_TRAVERSAL_COST and each
+	// primitive 1, weighted by its share of the root's surface area
+	float sahCost() const;
 
-	static int BoundingVolumeIntersections()	{ return BVIntersections; }
-	static int PrimitiveIntersections()			{ return PrimIntersections; }
+	// the hierarchy itself, for BVHAnalysis (NULL if nothing was built)
+	const BoundingVolume * root() const	{ return m_BVHRoot; }
+	// memory held by the nodes, and by the primitive references the leaves point into
+	size_t nodeBytes() const			{ return m_nodeArena.bytesReserved(); }
+	size_t primitiveBytes() const		{ return m_primitives.capacity() * sizeof( PrimitiveRef ); }
 
 protected:
-    Objects * m_objects;
+    Objects m_objects;
+	TriangleMeshes m_meshes;
+	PrimitiveRefs m_primitives; // reordered during the build so that every leaf is a contiguous range
 	BoundingVolume * m_BVHRoot;
+	MemoryArena m_nodeArena; // every node of the hierarchy lives here
+	MemoryArena m_scratchArena; // temporary memory used while building
 	int m_numNodes;
 	int m_numLeaves;
+	size_t m_countedPrimitiveBytes; // primitiveBytes() as counted in MemoryStats
+
+	bool intersectNode( const BoundingVolume * node, HitInfo& minHit, const Ray& ray, float tMin, float tMax ) const;
+	bool intersectPrimitiveRef( const PrimitiveRef & prim, HitInfo& result, const Ray& ray, float tMin, float tMax ) const;
+	void getPrimitiveBounds( const PrimitiveRef & prim, Vector3 &min, Vector3 &max ) const;
+	Vector3 getPrimitiveMidPoint( const PrimitiveRef & prim ) const;
 
 	float computeCost( float parentSurfaceArea, float childSurfaceArea, unsigned int childNumObjs );
-	BoundingVolume * buildBVH( Objects * objs );
+	static float nodeSAHCost( const BoundingVolume * node );
+	BoundingVolume * buildBVH( unsigned int first, unsigned int count );
 
 	typedef struct MidPointMap {
 		Vector3 midPoint;
@@ -51,17 +73,15 @@ protected:
 		float rightBVCost;
 	} SplitStats;
 
-	MidPointMap * getTriangleMinMaxAndMidpoints( Objects *objs, Vector3 &min, Vector3 &max, bool setMidPoints );
-	SplitStats findBestSplit( Objects * objs, MidPointMap * sortedMidPointMap, int numMidPoints, float parentSurfaceArea );
+	MidPointMap * getMinMaxAndMidpoints( const PrimitiveRef * prims, unsigned int count, Vector3 &min, Vector3 &max, bool setMidPoints );
+	SplitStats findBestSplit( const PrimitiveRef * prims, MidPointMap * sortedMidPointMap, int numMidPoints, float parentSurfaceArea );
+
+	static void growBounds( Vector3 &min, Vector3 &max, const Vector3 &objMin, const Vector3 &objMax, bool minAndMaxSet );
 
 	// functions to use with qsort
 	static int sortByXComponent( const void * p1, const void * p2 );
 	static int sortByYComponent( const void * p1, const void * p2 );
 	static int sortByZComponent( const void * p1, const void * p2 );
-
-private:
-	static int BVIntersections;
-	static int PrimIntersections;
 };
 
 #endif // CSE168_BVH_H_INCLUDED
@@ -0,0 +1,55 @@
+#ifndef CSE168_BVH_ANALYSIS_H_INCLUDED
+#define CSE168_BVH_ANALYSIS_H_INCLUDED
+
+#include "BVH.h"
+#include "RenderStats.h"
+#include <vector>
+
+/*
+    How good a BVH is, for comparing builders and leaf sizes
+    (NUM_LEAF_CHILDREN) objectively (-bvh-analysis):
+
+        SAH cost        BVH::sahCost(), what the tree should cost a ray
+        depths          how many leaves there are at each depth
+        leaf sizes      how many leaves hold 1, 2, ... primitives
+        overlap         the surface area the two children of each node share,
+                        as a fraction of all the inner nodes' surface area.
+                        overlapping children both get visited
+        memory          the nodes' and primitive references' bytes
+
+    measuredCost() is the cost a render's rays actually paid, in the same
+    units as the SAH cost, so the estimate can be checked against the ray
+    distribution a scene really has. exportOBJ() writes every node's box as
+    lines, one group per depth, to look at in a model viewer.
+
+    Only the scene's top level hierarchy is analyzed; the meshes that
+    Instances share have hierarchies of their own.
+*/
+class BVHAnalysis
+{
+public:
+	explicit BVHAnalysis( const BVH & bvh );
+
+	void print() const;
+	// writes the boxes of the nodes down to maxDepth (-1 for all of them). returns false if it can't
+	bool exportOBJ( const char * filename, int maxDepth = -1 ) const;
+
+	// the cost per ray of the tests counted in counters: a node test costs SAH_TRAVERSAL_COST, a primitive test 1
+	static double measuredCost( const RenderStats::Counters & counters );
+
+	float sahCost;
+	int numNodes;
+	int numLeaves;
+	std::vector<int> leavesAtDepth;     // indexed by depth; the root is at 0
+	std::vector<int> leavesWithSize;    // indexed by number of primitives
+	double overlapRatio;
+	size_t nodeBytes;
+	size_t primitiveBytes;
+
+private:
+	void addNode( const BoundingVolume * node, int depth, double & overlapArea, double & innerArea );
+
+	const BVH & m_bvh;
+};
+
+#endif // CSE168_BVH_ANALYSIS_H_INCLUDED
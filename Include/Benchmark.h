@@ -0,0 +1,32 @@
+#ifndef CSE168_BENCHMARK_H_INCLUDED
+#define CSE168_BENCHMARK_H_INCLUDED
+
+#define BENCHMARK_IMAGE_SIZE 512            // primary rays are a BENCHMARK_IMAGE_SIZE^2 pinhole image
+#define BENCHMARK_NUM_RANDOM_RAYS 262144
+#define BENCHMARK_NUM_RUNS 3                // each ray set is timed this many times; the fastest counts
+#define BENCHMARK_SEED 1234                 // so every run fires the same rays
+
+/*
+    BVH build and traversal benchmark (-benchmark). Each of the meshes in
+    Resource is loaded on its own and has a BVH built over it, which is then
+    hit with three fixed sets of rays:
+
+        primary     a pinhole camera's eye rays; coherent
+        random      random origins inside the mesh's bounds, random directions
+        shadow      from each primary ray's hit to a point light above the mesh
+
+    For each mesh and ray set it reports the build time and SAH cost, the
+    rays per second, and the node and primitive tests per ray, so changes to
+    the BVH can be tracked over time. With -perf-counters it also reports
+    the IPC and the cache and branch misses per ray, if the machine has them.
+*/
+class Benchmark
+{
+public:
+	// runs the benchmark, prints the results and writes them to filename, as
+	// CSV if it ends in .csv and otherwise JSON. returns false if it can't, or
+	// if any of the meshes couldn't be loaded (the others are still written)
+	static bool run( const char * filename );
+};
+
+#endif // CSE168_BENCHMARK_H_INCLUDED
@@ -0,0 +1,106 @@
+#ifndef CSE168_BENCHMARK_UTIL_H_INCLUDED
+#define CSE168_BENCHMARK_UTIL_H_INCLUDED
+
+#include "PerfCounters.h"
+#include "Vector3.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class Random;
+class TriangleMesh;
+
+/*
+    What the benchmarks (-benchmark and -benchmark-shading) have in common:
+    timing the same work several times and keeping the fastest run,
+    writing their results as CSV or JSON, and a few small helpers.
+*/
+
+// the fastest of several runs of the same work, with the hardware counters
+// (see PerfCounters) that run read, if there were any
+class BenchmarkTiming
+{
+public:
+	BenchmarkTiming() {clear();}
+
+	// forgets every run
+	void clear();
+	// times a run: start() right before the work and stop() right after. the
+	// run is kept if it's the first or the fastest so far
+	void start();
+	void stop();
+
+	double seconds() const                          {return m_seconds;}
+	bool haveCounters() const                       {return m_have_counters;}
+	const PerfCounters::Sample& counters() const    {return m_counters;}
+	// the fastest run's count of counter per unit of work, when the run did count units (rays, say)
+	double perUnit( PerfCounters::Counter counter, int count ) const;
+
+private:
+	int m_num_runs;
+	double m_seconds;
+	bool m_have_counters;
+	PerfCounters::Sample m_counters;
+
+	// the run being timed
+	double m_start;
+	bool m_counting;
+	PerfCounters::Sample m_before;
+};
+
+// writes one row per result, as CSV if the file name ends in .csv and
+// otherwise as JSON ({"results": [{...}, ...]}). every row has the same
+// columns in the same order; the CSV header comes from the first row's
+class BenchmarkWriter
+{
+public:
+	BenchmarkWriter();
+	~BenchmarkWriter();
+
+	// returns false (and says so) if the file can't be opened
+	bool open( const char * filename );
+
+	// a value for the whole file, before any rows. JSON only; CSV has nowhere to put it
+	void addProperty( const char * name, int value );
+
+	// the row's columns. strings are written as they are in CSV, so they mustn't have commas
+	void addString( const char * column, const char * value );
+	void addInt( const char * column, int value );
+	void addDouble( const char * column, double value, int decimals );
+	// an empty CSV cell; JSON leaves the column out
+	void addMissing( const char * column );
+	// ipc, cache_misses_per_<unit> and branch_misses_per_<unit> from the timing's
+	// counters for count units of work, or missing if it has none
+	void addCounters( const BenchmarkTiming & timing, int count, const char * unit );
+	void endRow();
+
+	// finishes the file. returns false if anything couldn't be written
+	bool close();
+
+private:
+	void add( const char * column, const std::string & value, bool present );
+	void beginResults();
+
+	FILE * m_fp;
+	bool m_csv;
+	int m_num_rows;
+	bool m_began_results;
+	std::vector<std::string> m_columns;
+	std::vector<std::string> m_values;
+	std::vector<bool> m_present;
+};
+
+class BenchmarkUtil
+{
+public:
+	// a point uniformly distributed on the unit sphere
+	static Vector3 randomDirection( Random & random );
+
+	// whether filename ends in .csv (or .CSV)
+	static bool isCSV( const char * filename );
+
+	// TriangleMesh::load() with a file name that isn't writable
+	static bool loadMesh( TriangleMesh & mesh, const char * filename );
+};
+
+#endif // CSE168_BENCHMARK_UTIL_H_INCLUDED
@@ -2,13 +2,17 @@
 #define CSE168_BOUNDING_BOX_H_INCLUDED
 
 #include "BoundingVolume.h"
+#include "MemoryArena.h"
 
 class BoundingBox : public BoundingVolume
 {
 public:
-	BoundingBox( Objects * objects, bool isLeaf, Vector3 vecMin, Vector3 vecMax );
+	BoundingBox( bool isLeaf, Vector3 vecMin, Vector3 vecMax );
 	virtual ~BoundingBox();
 
+	// constructs a box in the arena; it lives until the arena is released
+	static BoundingBox * create( MemoryArena & arena, bool isLeaf, Vector3 vecMin, Vector3 vecMax );
+
 	enum IntersectingPlane
 	{
 		XMIN_PLANE,
@@ -20,7 +24,8 @@ public:
 	};
 
 	virtual void renderGL();
-	virtual bool intersect( HitInfo& result, const Ray& ray, float tMin = 0.0f, float tMax = MIRO_TMAX );
+	virtual bool intersect( const Ray& ray, float tMin = 0.0f, float tMax = MIRO_TMAX ) const;
+	virtual void getBounds( Vector3& vMin, Vector3& vMax ) const	{ vMin = m_vMin; vMax = m_vMax; }
 
 	static float calcPotentialSurfaceArea( Vector3 min, Vector3 max );
 
@@ -2,28 +2,60 @@
 #define CSE168_BOUNDING_VOLUME_H_INCLUDED
 
 #define VIEW_BOUNDING_VOLUMES 0
+#define NUM_NODE_CHILDREN 2 // don't change this
 
-#include "Object.h"
+#include <vector>
+#include "Miro.h"
 #include "Ray.h"
 
-class BoundingVolume : public Object
+/*
+    Identifies one primitive in a BVH without needing an Object for it:
+    either triangle 'index' of the BVH's mesh number 'mesh', or, if mesh
+    is OBJECT, the BVH's generic Object number 'index'.
+*/
+struct PrimitiveRef
+{
+	static const unsigned int OBJECT = 0xffffffff;
+
+	unsigned int mesh;
+	unsigned int index;
+};
+
+typedef std::vector<PrimitiveRef> PrimitiveRefs;
+
+/*
+    Bounding volumes are allocated from the BVH's node arena and never deleted
+    individually, so they mustn't own any memory. A leaf refers to a range of
+    the BVH's primitive array instead of keeping its own list.
+*/
+class BoundingVolume
 {
 public: 
-	BoundingVolume( Objects * objects, bool isLeaf );
+	BoundingVolume( bool isLeaf );
 	virtual ~BoundingVolume();
 
 	virtual void renderGL() {}
-	virtual bool intersect( HitInfo& result, const Ray& ray, float tMin = 0.0f, float tMax = MIRO_TMAX ) = 0;
 
-	const Objects * getChildren() const	{ return &m_children; }
-	bool isLeaf() const					{ return m_bIsLeaf; }
+	// only tests the volume itself; the BVH is responsible for visiting the contents
+	virtual bool intersect( const Ray& ray, float tMin = 0.0f, float tMax = MIRO_TMAX ) const = 0;
+	virtual void getBounds( Vector3& vMin, Vector3& vMax ) const = 0;
+
+	int numChildren() const							{ return m_numChildren; }
+	const BoundingVolume * getChild( int i ) const	{ return m_children[i]; }
+	unsigned int firstPrimitive() const				{ return m_firstPrimitive; }
+	unsigned int numPrimitives() const				{ return m_numPrimitives; }
+	bool isLeaf() const								{ return m_bIsLeaf; }
 
-	void addChild( Object * child );
+	void addChild( BoundingVolume * child );
+	void setPrimitives( unsigned int first, unsigned int count );
 	void calcNumNodesAndLeaves( int * numNodesPtr, int * numLeavesPtr );
 
 protected:
 	bool m_bIsLeaf;
-	Objects m_children; // if it's a leaf, children will be primitives. Otherwise they'll be bounding volumes.
+	int m_numChildren;
+	BoundingVolume * m_children[NUM_NODE_CHILDREN]; // only used if this isn't a leaf
+	unsigned int m_firstPrimitive; // only used if this is a leaf
+	unsigned int m_numPrimitives;
 };
 
-#endif // CSE168_BOUNDING_VOLUME_H_INCLUDED
\ No newline at end of file
+#endif // CSE168_BOUNDING_VOLUME_H_INCLUDED
@@ -33,7 +33,7 @@ public:
     inline void setLookAt(const Vector3& look);
     inline void setBGColor(float x, float y, float z);
     inline void setBGColor(const Vector3& color);
-    inline void setFOV(float fov) {m_fov = fov;}
+    inline void setFOV(float fov) {m_fov = fov; m_frame_dirty = true;}
 	inline void setFocalPlaneDistance(float focalPlaneDistance);
 	inline void setAperture(float aperture);
 
@@ -45,15 +45,26 @@ public:
     inline const Vector3 & bgColor() const  {return m_bgColor;}
 
     Ray eyeRay(int x, int y, int imageWidth, int imageHeight);
-	// returns true if intersection with focal plane is successful (and sets desiredFocalPlanePt to that intersection). returns false otherwise.
-	bool getFocalPlaneIntersection( Vector3& desiredFocalPlanePt, const Vector3 hitPt ) const;
-	Vector3 getRandomApertureSample() const;
+	// eye ray through the point (offsetX, offsetY) in [0,1)^2 of pixel (x, y) rather than its center
+	Ray eyeRay(int x, int y, float offsetX, float offsetY, int imageWidth, int imageHeight);
+	// fills rays (tileWidth * tileHeight of them, row by row) with the eye rays
+	// for the tile of the image whose bottom-left pixel is (x0, y0)
+	void eyeRays(Ray * rays, int x0, int y0, int tileWidth, int tileHeight, int imageWidth, int imageHeight);
+	// thin lens: returns the ray through lens sample (lensU, lensV) in [0,1)^2 that
+	// converges with pinholeRay (an eye ray from this camera) on the focal plane
+	Ray lensRay(const Ray& pinholeRay, float lensU, float lensV) const;
+	// diameter, in pixels, of the circle of confusion of a point in front of the camera.
+	// only valid after eyeRay()/eyeRays() have been called for the current image size
+	float circleOfConfusion(const Vector3& pt) const;
+	// the circle of confusion of a point infinitely far away (the largest one behind the focal plane)
+	float maxCircleOfConfusion() const;
     
     void drawGL();
 
 private:
     void calcLookAt();
-	void calcAperturePlaneAxes();
+	// recomputes the camera basis and image plane deltas if anything changed since the last call
+	void calcFrame(int imageWidth, int imageHeight);
 
     Vector3 m_bgColor;
     int m_renderer;
@@ -66,7 +77,17 @@ private:
     float m_fov;
 	float m_focal_plane_distance;
 	float m_aperture; // radius of aperture. Camera position is the center of the aperture opening.
-	Vector3 m_aperture_plane_axis1, m_aperture_plane_axis2;
+
+	// cached per frame by calcFrame(). pixel (x, y)'s eye ray direction is
+	// m_pixel_origin_dir + x * m_pixel_delta_u + y * m_pixel_delta_v (unnormalized)
+	bool m_frame_dirty;
+	int m_frame_width, m_frame_height;
+	Vector3 m_pixel_origin_dir;
+	Vector3 m_pixel_delta_u, m_pixel_delta_v;
+	// the lens disc's axes (the camera's right and up directions) scaled by the aperture radius
+	Vector3 m_lens_axis_u, m_lens_axis_v;
+	// height of one pixel at unit distance in front of the camera
+	float m_pixel_size;
 };
 
 extern Camera * g_camera;
@@ -76,8 +97,7 @@ extern Camera * g_camera;
 inline void Camera::setEye(float x, float y, float z)
 {
     m_eye.set(x, y, z);
-
-	calcAperturePlaneAxes();
+    m_frame_dirty = true;
 }
 
 inline void Camera::setEye(const Vector3& eye)
@@ -89,6 +109,7 @@ inline void Camera::setUp(float x, float y, float z)
 {
     m_up.set(x, y, z);
     m_up.normalize();
+    m_frame_dirty = true;
 }
 
 inline void Camera::setUp(const Vector3& up)
@@ -100,8 +121,7 @@ inline void Camera::setViewDir(float x, float y, float z)
 {
     m_viewDir.set(x, y, z);
     m_viewDir.normalize();
-
-	calcAperturePlaneAxes();
+    m_frame_dirty = true;
 }
 
 inline void Camera::setViewDir(const Vector3& vd)
@@ -140,8 +160,7 @@ inline void Camera::setAperture(float aperture)
 {
 	assert( aperture > 0 );
 	m_aperture = aperture;
-
-	calcAperturePlaneAxes();
+	m_frame_dirty = true;
 }
 
 #endif // CSE168_CAMERA_H_INCLUDED
@@ -4,5 +4,7 @@ void warning(const char *fmt,...);
 void error(const char *fmt,...);
 void debug(const char *fmt,...);
 void fatal(const char *fmt,...);
+// how many times error() has been called, so a caller can tell whether something it ran failed
+int errorCount();
 
 #endif // CSE168_CONSOLE_H_INCLUDED
@@ -0,0 +1,66 @@
+#ifndef CSE168_COST_MAP_H_INCLUDED
+#define CSE168_COST_MAP_H_INCLUDED
+
+#include "RenderStats.h"
+#include "Timer.h"
+#include <vector>
+
+/*
+    What each pixel of a render cost: the time spent on it and the BVH
+    nodes, primitive tests and shadow rays that took, added up over all of
+    its samples. It shows where the expensive geometry and materials are.
+
+    snapshot() before a pixel's work and add() after it charges the pixel
+    with the difference (the counts come from the calling thread's
+    RenderStats, so they have to be compiled in). write() saves every metric
+    as a false colour .ppm, scaled so the 99th percentile pixel is white
+    (the most expensive 1% all clamp to white, so a few outliers don't
+    leave the rest dark), and as a .pfm of the raw values.
+*/
+class CostMap
+{
+public:
+	enum Metric
+	{
+		TIME,               // nanoseconds
+		BVH_NODES,          // ray <=> bounding volume tests
+		PRIMITIVE_TESTS,
+		SHADOW_RAYS,
+		NUM_METRICS
+	};
+
+	struct Snapshot
+	{
+		double time;
+		RenderStats::Counters counters;
+	};
+
+	CostMap() : m_width(0), m_height(0) {}
+
+	void resize( int width, int height ); // and zeroes it
+	bool isEmpty() const        {return m_width == 0;}
+
+	static Snapshot snapshot()
+	{
+		Snapshot s;
+		s.time = Timer::now();
+		s.counters = RenderStats::local();
+		return s;
+	}
+	// charges pixel (x, y) with everything since the snapshot
+	void add( int x, int y, const Snapshot& since );
+
+	float value( Metric metric, int x, int y ) const {return m_values[metric][y * m_width + x];}
+	// the name a metric has in file names, like "bvh_nodes"
+	static const char * metricName( int metric );
+
+	// writes <prefix>_<metric>.ppm and .pfm for every metric. returns false if any can't be written
+	bool write( const char * prefix ) const;
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<float> m_values[NUM_METRICS];
+};
+
+#endif // CSE168_COST_MAP_H_INCLUDED
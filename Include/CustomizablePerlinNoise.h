@@ -2,11 +2,13 @@
 #define CUSTOMIZABLE_PERLIN_H
 
 #include <stdlib.h>
+#include "MemoryStats.h"
 
 
 #define SAMPLE_SIZE 1024
 
-class CustomizablePerlinNoise
+// its tables take about 57 KB, counted as MemoryStats::NOISE_TABLES
+class CustomizablePerlinNoise : public MemoryTracked<MemoryStats::NOISE_TABLES>
 {
 public:
   /*
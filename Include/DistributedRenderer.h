@@ -0,0 +1,38 @@
+#ifndef CSE168_DISTRIBUTED_RENDERER_H_INCLUDED
+#define CSE168_DISTRIBUTED_RENDERER_H_INCLUDED
+
+#include "Miro.h"
+
+#define DISTRIBUTED_TILES_IN_FLIGHT 2 // tiles handed to a worker before it sends any back
+#define DISTRIBUTED_CONNECT_TIMEOUT 30 // seconds a worker keeps trying to reach the coordinator
+
+/*
+    Renders the image's tiles in other processes (on this machine or others).
+
+    The coordinator listens on a TCP port and hands TILE_SIZE x TILE_SIZE tiles
+    out to whichever workers connect, a couple at a time, assembling the float
+    pixels they send back into the image. A worker that disconnects (or dies)
+    has its unfinished tiles handed to the others.
+
+    Workers run the same program with the same scene, so each builds its own
+    BVH (and photon map, from the coordinator's seed) once and then renders
+    whatever tiles it's given. Every tile is seeded from its position, so the
+    result doesn't depend on which worker rendered what; with -seed it matches
+    a single process render exactly.
+
+    Messages are sent in the host's byte order, so all machines must agree on it.
+*/
+class DistributedRenderer
+{
+public:
+	// renders img using workers; returns once every tile is back. the rays the
+	// workers traced are added to the RenderStats totals, and each worker's
+	// share (dropped ones included) is printed at the end
+	static void coordinate( unsigned short port, unsigned int seed, Image *img, Scene *scene );
+
+	// connects to the coordinator and renders tiles for it until it's finished.
+	// returns 0 on success (the process exit code)
+	static int work( const char * host, unsigned short port, Camera *cam, Image *img, Scene *scene );
+};
+
+#endif // CSE168_DISTRIBUTED_RENDERER_H_INCLUDED
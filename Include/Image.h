@@ -3,6 +3,8 @@
 
 #include "Vector3.h"
 
+#define USE_HDR_FRAMEBUFFER 1 // keep float pixels and tone map only when displaying or writing
+
 class Image
 {
 public:
@@ -21,20 +23,46 @@ public:
     void setPixel(int x, int y, const Vector3& p);
     void setPixel(int x, int y, const Pixel& p);
 
+    // HDR mode keeps a float RGB value and sample count per pixel. the 8-bit
+    // pixels are only filled in (tone mapped) when they're drawn or written out
+    void setHDR(bool hdr);
+    bool isHDR() const              {return m_hdr_pixels != 0;}
+    // averages another sample into the pixel (HDR mode only)
+    void addSample(int x, int y, const Vector3& p);
+    Vector3 getPixel(int x, int y) const;
+    int numSamples(int x, int y) const;
+    // the raw HDR buffers (0 in 8-bit mode): 3 floats (sums) and a sample count per pixel
+    float* getFloatPixels()         {return m_hdr_pixels;}
+    unsigned int* getSampleCounts() {return m_sample_counts;}
+    // scale applied to HDR values before they're clamped to 8 bits
+    void setExposure(float exposure) {m_exposure = exposure;}
+    float exposure() const          {return m_exposure;}
+
     void draw();
     void drawScanline(int y);
     void clear(const Vector3& c);
+    // clears the pixels in [x0, x1) x [y0, y1)
+    void clear(const Vector3& c, int x0, int y0, int x1, int y1);
     void writePPM(char* pcFile); // write data to a ppm image file
     void writePPM(char *pcName, unsigned char *data, int width, int height);
 
-    unsigned char* getCharPixels()  {return (unsigned char*)m_pixels;}
+    unsigned char* getCharPixels()  {toneMap(0, m_height); return (unsigned char*)m_pixels;}
+    // row y (tone mapped if needed) as width * 3 bytes of RGB
+    const unsigned char* getCharScanline(int y) {toneMap(y, y+1); return (const unsigned char*)&m_pixels[y*m_width];}
     int width() const               {return m_width;}
     int height() const              {return m_height;}
 
 private:
+    // converts rows [y0, y1) of the HDR pixels to 8 bits (does nothing in 8-bit mode)
+    void toneMap(int y0, int y1);
+
     Pixel* m_pixels;
     int m_width;
     int m_height;
+
+    float* m_hdr_pixels; // 3 floats per pixel: the sum of its samples
+    unsigned int* m_sample_counts;
+    float m_exposure;
 };
 
 extern Image * g_image;
@@ -0,0 +1,78 @@
+#ifndef CSE168_IMAGE_WRITER_H_INCLUDED
+#define CSE168_IMAGE_WRITER_H_INCLUDED
+
+#include <stdio.h>
+#include <vector>
+
+class Image;
+
+/*
+    Writes an image to disk a scanline at a time, so rows can be saved as soon
+    as they're finished rendering instead of all at once at the end. The file
+    format is picked from the file name's extension by create():
+
+        .ppm    8-bit binary PPM (tone mapped)
+        .pfm    32-bit float RGB PFM, the format PFMLoader reads (raw HDR values)
+        .tga    8-bit run length encoded Targa (tone mapped, lossless)
+
+    Scanlines are numbered like Image's, with row 0 at the bottom, and must be
+    written from the bottom up. Everything written so far is flushed to the
+    file, so a partial render survives a crash.
+*/
+class ImageWriter
+{
+public:
+	// returns 0 (and prints why) if the extension isn't one of the above
+	static ImageWriter* create( const char * filename );
+	virtual ~ImageWriter();
+
+	bool open( const char * filename, int width, int height );
+	// writes row y of img, which must be the next row up from the last one written
+	bool writeScanline( Image & img, int y );
+	// writes any rows of img that haven't been written yet
+	bool writeImage( Image & img );
+	void close();
+
+	bool isOpen() const         {return m_file != 0;}
+	int numRowsWritten() const  {return m_next_row;}
+
+protected:
+	ImageWriter();
+
+	virtual bool writeHeader() = 0;
+	virtual bool writeRow( Image & img, int y ) = 0;
+
+	FILE * m_file;
+	int m_width;
+	int m_height;
+	int m_next_row;
+};
+
+class PPMWriter : public ImageWriter
+{
+protected:
+	virtual bool writeHeader();
+	virtual bool writeRow( Image & img, int y );
+
+	long m_data_offset;
+};
+
+class PFMWriter : public ImageWriter
+{
+protected:
+	virtual bool writeHeader();
+	virtual bool writeRow( Image & img, int y );
+
+	std::vector<float> m_row;
+};
+
+class TGAWriter : public ImageWriter
+{
+protected:
+	virtual bool writeHeader();
+	virtual bool writeRow( Image & img, int y );
+
+	std::vector<unsigned char> m_packets;
+};
+
+#endif // CSE168_IMAGE_WRITER_H_INCLUDED
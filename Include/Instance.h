@@ -0,0 +1,38 @@
+#ifndef CSE168_INSTANCE_H_INCLUDED
+#define CSE168_INSTANCE_H_INCLUDED
+
+#include "Object.h"
+#include "Matrix4x4.h"
+
+/*
+    An Instance places a shared TriangleMesh in the scene through its own
+    transform. The mesh's triangles and bottom-level BVH live in the mesh's
+    object space and are built only once, no matter how many Instances
+    reference them; rays are transformed into object space for intersection.
+*/
+class Instance : public Object
+{
+public:
+    Instance(TriangleMesh * mesh, const Matrix4x4& xform);
+    virtual ~Instance();
+
+    TriangleMesh * getMesh()            {return m_mesh;}
+    const Matrix4x4 & transform() const {return m_xform;}
+
+    virtual void renderGL();
+    virtual bool intersect(HitInfo& result, const Ray& ray,
+                           float tMin = 0.0f, float tMax = MIRO_TMAX);
+
+    virtual void getBounds(Vector3& vMin, Vector3& vMax) const;
+    virtual Vector3 getMidPoint() const;
+
+protected:
+    TriangleMesh * m_mesh;
+    Matrix4x4 m_xform;          // object space -> world space
+    Matrix4x4 m_inverse_xform;  // world space -> object space
+    Matrix4x4 m_normal_xform;   // inverse transpose, for transforming normals to world space
+
+    static Vector3 transformDirection(const Matrix4x4& m, const Vector3& d);
+};
+
+#endif // CSE168_INSTANCE_H_INCLUDED
@@ -4,8 +4,9 @@
 #include "Miro.h"
 #include "Vector3.h"
 #include "CustomizablePerlinNoise.h"
+#include "MemoryStats.h"
 
-class Material
+class Material : public MemoryTracked<MemoryStats::MATERIALS>
 {
 public:
     Material();
@@ -0,0 +1,44 @@
+#ifndef CSE168_MATERIAL_LIBRARY_H_INCLUDED
+#define CSE168_MATERIAL_LIBRARY_H_INCLUDED
+
+#include <map>
+#include <string>
+#include "Material.h"
+#include "CustomizablePerlinNoise.h"
+
+/*
+    Owns every Material loaded from a .mtl file and every bump map noise maker.
+    Each .mtl file is parsed once and the resulting Material is shared by all the
+    faces (and meshes) that use it; noise makers with identical parameters are
+    shared the same way. Nothing handed out here should be deleted by the caller.
+*/
+class MaterialLibrary
+{
+public:
+	// returns the material described by fileName.mtl, or NULL if it couldn't be loaded
+	static Material * getMaterial( char * fileName );
+
+	static CustomizablePerlinNoise * getNoiseMaker( int octaves, float freq, float amp, int seed );
+
+	// deletes all materials and noise makers in the library
+	static void clear();
+
+protected:
+	struct NoiseParams
+	{
+		int octaves;
+		float freq;
+		float amp;
+		int seed;
+
+		bool operator<( const NoiseParams & other ) const;
+	};
+
+	typedef std::map<std::string, Material *> MaterialMap;
+	typedef std::map<NoiseParams, CustomizablePerlinNoise *> NoiseMakerMap;
+
+	static MaterialMap m_materials;
+	static NoiseMakerMap m_noise_makers;
+};
+
+#endif // CSE168_MATERIAL_LIBRARY_H_INCLUDED
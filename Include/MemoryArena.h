@@ -0,0 +1,60 @@
+#ifndef CSE168_MEMORY_ARENA_H_INCLUDED
+#define CSE168_MEMORY_ARENA_H_INCLUDED
+
+#include "MemoryStats.h"
+#include <vector>
+#include <stddef.h>
+
+#define MEMORY_ARENA_BLOCK_SIZE ( 256 * 1024 )
+#define MEMORY_ARENA_ALIGNMENT 16
+
+/*
+    A bump allocator. Allocations are carved out of large blocks one after
+    another and are never freed individually; instead, everything allocated
+    after a mark() can be thrown away at once with rewind(), or everything
+    with reset(). Blocks are kept around for reuse until release() (or the
+    destructor) frees them.
+
+    No destructors are run for anything allocated here, so it's only suitable
+    for objects that don't own any other memory. The blocks count in
+    MemoryStats under the arena's category.
+*/
+class MemoryArena
+{
+public:
+	MemoryArena( MemoryStats::Category category, size_t blockSize = MEMORY_ARENA_BLOCK_SIZE );
+	~MemoryArena();
+
+	typedef struct Marker {
+		size_t block;
+		size_t offset;
+	} Marker;
+
+	void * alloc( size_t numBytes );
+	template <class T> T * alloc( size_t count ) { return ( T * )alloc( count * sizeof( T ) ); }
+
+	Marker mark() const;
+	void rewind( const Marker & marker );
+	void reset();
+	void release();
+
+	size_t bytesReserved() const;
+
+private:
+	typedef struct Block {
+		char * data;
+		size_t size;
+	} Block;
+
+	std::vector<Block> m_blocks;
+	MemoryStats::Category m_category;
+	size_t m_blockSize;
+	size_t m_currentBlock;
+	size_t m_currentOffset;
+
+	// arenas own raw memory, so they can't be copied
+	MemoryArena( const MemoryArena & );
+	MemoryArena & operator=( const MemoryArena & );
+};
+
+#endif // CSE168_MEMORY_ARENA_H_INCLUDED
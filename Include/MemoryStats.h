@@ -0,0 +1,109 @@
+#ifndef CSE168_MEMORY_STATS_H_INCLUDED
+#define CSE168_MEMORY_STATS_H_INCLUDED
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+    How much memory each subsystem has allocated, now and at most, so it's
+    clear what to shrink when a big mesh and a big photon map don't fit.
+
+    Nothing hooks the allocator (DebugMem.h only works with the MSVC debug
+    runtime); each subsystem says what it allocates and frees instead:
+
+        mesh vertices   TriangleMesh vertex and texture coordinate arrays
+        mesh normals    TriangleMesh normal arrays
+        mesh indices    TriangleMesh vertex, normal, texture and material indices
+        triangles       Triangle objects
+        bvh nodes       BVH node arenas and leaf primitive references
+        bvh build       the BVH's scratch arenas, only needed while building
+        photon map      PhotonMap photons
+        environment map the Scene's environment map
+        noise tables    CustomizablePerlinNoise's tables
+        images          Image and AccumulationBuffer pixels
+        materials       Material objects
+
+    So it works in any build, on any platform. The report gives each
+    category's current and peak bytes; Profiler adds what's in use at the
+    end of each phase.
+*/
+class MemoryStats
+{
+public:
+	enum Category
+	{
+		MESH_VERTICES,
+		MESH_NORMALS,
+		MESH_INDICES,
+		TRIANGLES,
+		BVH_NODES,
+		BVH_BUILD,
+		PHOTON_MAP,
+		ENVIRONMENT_MAP,
+		NOISE_TABLES,
+		IMAGES,
+		MATERIALS,
+		NUM_CATEGORIES
+	};
+
+	static void add( Category category, size_t bytes );
+	static void remove( Category category, size_t bytes );
+	// ::operator new and delete, adding and removing the bytes (for MemoryTracked)
+	static void * allocate( Category category, size_t bytes );
+	static void deallocate( Category category, void * p, size_t bytes );
+
+	static size_t current( Category category );
+	static size_t peak( Category category );
+	// across all categories; the peak is of the sum, not the sum of the peaks
+	static size_t currentTotal();
+	static size_t peakTotal();
+
+	// the name a category has in reports, like "photon_map"
+	static const char * categoryName( int category );
+
+	// the categories that have allocated anything, one per line
+	static void print();
+	// the categories as a JSON object's members, each line starting with indent
+	static void writeJSON( FILE * fp, const char * indent );
+
+private:
+	static size_t s_current[NUM_CATEGORIES];
+	static size_t s_peak[NUM_CATEGORIES];
+	static size_t s_current_total;
+	static size_t s_peak_total;
+};
+
+// operator new and delete for classes whose objects count in a category
+// (through their most derived type's size, given a virtual destructor).
+// new and the sized delete are a matching pair; the global ones they call
+// are out of line, so the compiler never sees a class delete freeing what a
+// global new returned
+template <int CATEGORY>
+class MemoryTracked
+{
+public:
+	static void * operator new( size_t size )
+	{
+		return MemoryStats::allocate( (MemoryStats::Category)CATEGORY, size );
+	}
+	static void operator delete( void * p, size_t size )
+	{
+		MemoryStats::deallocate( (MemoryStats::Category)CATEGORY, p, size );
+	}
+#ifdef _DEBUG
+	// the form DebugMem.h's new uses, and the delete that goes with it if a
+	// constructor throws. that one isn't given the size, so the bytes stay counted
+	static void * operator new( size_t size, int blockType, const char * file, int line )
+	{
+		void * p = ::operator new( size, blockType, file, line );
+		MemoryStats::add( (MemoryStats::Category)CATEGORY, size );
+		return p;
+	}
+	static void operator delete( void * p, int blockType, const char * file, int line )
+	{
+		::operator delete( p, blockType, file, line );
+	}
+#endif
+};
+
+#endif // CSE168_MEMORY_STATS_H_INCLUDED
@@ -11,10 +11,56 @@ const float PI = 3.1415926535897932384626433832795028841972f;
 const float DegToRad = PI/180.0f;
 const float RadToDeg = 180.0f/PI; 
 
+#define USE_SSE 1 // use SSE/SSE2 intrinsics for primary ray generation and image conversion
+
 #include <stdlib.h>
 #include "OpenGL.h"
 #include <stdio.h>
 #include <iostream>
+#include <string>
+
+#ifndef WIN32
+// the loaders use Microsoft's bounds-checked CRT functions; elsewhere these
+// do the same with the standard ones
+#include <string.h>
+#include <errno.h>
+#define _TRUNCATE ((size_t)-1)
+#define sscanf_s sscanf
+#define fscanf_s fscanf
+
+inline int strncpy_s(char *dest, size_t size, const char *src, size_t count)
+{
+	const size_t n = count < size - 1 ? count : size - 1;
+	strncpy(dest, src, n);
+	dest[n] = '\0';
+	return 0;
+}
+
+inline int fopen_s(FILE **fp, const char *filename, const char *mode)
+{
+	*fp = fopen(filename, mode);
+	return *fp ? 0 : errno;
+}
+#endif
+
+// opens a scene asset (a mesh, material or environment map). their paths, in
+// the code and in .obj files, are written the Windows way ("Resource\\teapot.obj"),
+// so anywhere else the backslashes become slashes. returns 0 if it can't
+inline FILE * openAsset(const char *filename, const char *mode)
+{
+#ifdef WIN32
+	FILE *fp;
+	return fopen_s(&fp, filename, mode) == 0 ? fp : 0;
+#else
+	std::string path(filename);
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		if (path[i] == '\\')
+			path[i] = '/';
+	}
+	return fopen(path.c_str(), mode);
+#endif
+}
 
 class Ray;
 class HitInfo;
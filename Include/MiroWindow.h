@@ -16,9 +16,14 @@ public:
     void motion(int x, int y);
     
 protected:
+    // outlines the crop window being dragged out with the right mouse button
+    void drawSelection();
+
     float m_scaleFact;
     int   m_activeButton;
     int   m_mouseX, m_mouseY;
+    bool  m_selecting;              // dragging out a crop window over the ray traced image
+    int   m_selectX, m_selectY;     // where the drag started
 };
 
 #endif // CSE168_MIRO_GLUT_WINDOW_H_INCLUDED
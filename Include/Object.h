@@ -16,6 +16,9 @@ public:
     virtual void renderGL() {}
     virtual void preCalc() {}
 
+    // axis-aligned bounds and centroid used to place this object in a BVH
+    virtual void getBounds(Vector3& vMin, Vector3& vMax) const = 0;
+    virtual Vector3 getMidPoint() const = 0;
 
     virtual bool intersect(HitInfo& result, const Ray& ray,
                            float tMin = 0.0f, float tMax = MIRO_TMAX) = 0;
@@ -0,0 +1,61 @@
+#ifndef CSE168_PERF_COUNTERS_H_INCLUDED
+#define CSE168_PERF_COUNTERS_H_INCLUDED
+
+#define USE_PERF_COUNTERS 1 // 0 compiles the hardware counters out
+
+/*
+    Hardware performance counters (-perf-counters): cycles, instructions,
+    last level cache misses and branch misses, counted in user mode for the
+    calling thread. They come from Linux's perf_event_open(); anywhere else,
+    or when the kernel won't allow it (see /proc/sys/kernel/perf_event_paranoid,
+    and most virtual machines have no counters at all), isAvailable() is
+    false and read() does nothing, so everything still runs, just without
+    the counts.
+
+    Each thread opens its own counters the first time it reads them. A
+    Sample is a snapshot of them; the difference between two is what ran in
+    between.
+*/
+class PerfCounters
+{
+public:
+	enum Counter
+	{
+		CYCLES,
+		INSTRUCTIONS,
+		CACHE_MISSES,
+		BRANCH_MISSES,
+		NUM_COUNTERS
+	};
+
+	struct Sample
+	{
+		unsigned long long values[NUM_COUNTERS];
+
+		void clear();
+		// adds end - start
+		void addDifference( const Sample& start, const Sample& end );
+		// adds that fraction (0 to 1) of end - start, rounded
+		void addDifference( const Sample& start, const Sample& end, double fraction );
+		// instructions per cycle, or 0 if nothing was counted
+		double ipc() const;
+	};
+
+	// starts counting on the calling thread; prints why not and returns false if it can't
+	static bool enable();
+	static bool isEnabled()     {return s_enabled;}
+	// whether enable() worked
+	static bool isAvailable()   {return s_enabled && s_available;}
+
+	// the calling thread's counts so far. returns false (and leaves sample alone) if they aren't available
+	static bool read( Sample& sample );
+
+	// the name a counter has in reports, like "cache_misses"
+	static const char * counterName( int counter );
+
+private:
+	static bool s_enabled;
+	static bool s_available;
+};
+
+#endif // CSE168_PERF_COUNTERS_H_INCLUDED
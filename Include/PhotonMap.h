@@ -59,6 +59,10 @@ public:
 
   void balance(void);              // balance the kd-tree (before use!)
 
+  int save( const char *filename ) const;   // write the balanced map to a file (returns 0 on failure)
+  static PhotonMap *load(
+    const char *filename );        // read a map written by save() (returns NULL on failure)
+
   void irradiance_estimate(
     float irrad[3],                // returned irradiance
     const float pos[3],            // surface position
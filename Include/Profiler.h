@@ -0,0 +1,189 @@
+#ifndef CSE168_PROFILER_H_INCLUDED
+#define CSE168_PROFILER_H_INCLUDED
+
+#include "Atomic.h"
+#include "PerfCounters.h"
+#include "MemoryStats.h"
+#include "Timer.h"
+#include "TraceRecorder.h"
+
+#define USE_PROFILER 1 // 0 compiles every PROFILE_SCOPE out
+
+/*
+    Wall clock time spent in each phase of loading and rendering a scene.
+
+    PROFILE_SCOPE(phase) at the top of a block times the rest of the block
+    and adds it to the phase's total. Phases nest (a BVH build happens during
+    the scene load; shading traces reflection and shadow rays), and each
+    phase's time includes whatever ran inside it.
+
+    Like RenderStats, every thread adds to its own totals and merge()s them
+    when it's done. writeJSON() writes the merged totals, along with the
+    render's ray counts, for scripts to track; reset() starts the next
+    report from zero.
+
+    When -trace is on, each run of a phase is also a span in the trace,
+    except for the per pixel ones, which would swamp it.
+
+    With -perf-counters, each phase also totals the hardware counters
+    (PerfCounters) its runs took, when the machine has them. The per pixel
+    phases don't read them themselves, since two system calls would cost
+    more than most pixels do. Instead PROFILE_PER_PIXEL_COUNTERS reads them
+    around a tile (or a row of an adaptive or progressive pass), and each
+    per pixel phase gets the share of those counts that its time is of the
+    tile's. That assumes the events are spread evenly over the time, so
+    their counts are estimates; the other phases' are exact.
+
+    Every phase but the per pixel ones also notes the memory (MemoryStats)
+    in use when it ends, and the peak up to then.
+*/
+class Profiler
+{
+public:
+	enum Phase
+	{
+		SCENE_LOAD,         // building the scene, including everything below it
+		OBJ_PARSE,          // reading .obj files
+		BVH_BUILD,
+		PHOTON_EMISSION,    // tracing photons from the lights
+		PHOTON_BALANCE,     // balancing the photon map's kd-tree
+		PRIMARY_TRACING,    // finding what eye rays hit (not shading it)
+		SHADING,            // shading eye ray hits, including the rays that takes
+		PHOTON_GATHER,      // looking up the photons near a shading point
+		IMAGE_WRITE,
+		NUM_PHASES
+	};
+
+	struct Totals
+	{
+		double seconds[NUM_PHASES];
+		unsigned long long calls[NUM_PHASES];
+		PerfCounters::Sample counters[NUM_PHASES];
+		size_t memory[NUM_PHASES];      // the most in use at the end of a run
+		size_t peakMemory[NUM_PHASES];  // the peak at the end of the last run
+
+		void clear();
+		void add( const Totals& other );
+	};
+
+	static void add( Phase phase, double seconds )
+	{
+		s_local.seconds[phase] += seconds;
+		s_local.calls[phase]++;
+	}
+	// adds a run of the phase from start to end (Timer::now() values), and traces it
+	static void add( Phase phase, double start, double end )
+	{
+		add( phase, end - start );
+		if( !isPerPixel( phase ) )
+		{
+			TraceRecorder::span( phaseName( phase ), "phase", start, end );
+			const size_t memory = MemoryStats::currentTotal();
+			if( memory > s_local.memory[phase] )
+				s_local.memory[phase] = memory;
+			s_local.peakMemory[phase] = MemoryStats::peakTotal();
+		}
+	}
+	// adds the hardware counts a run of the phase took, from the samples at its start and end
+	static void addCounters( Phase phase, const PerfCounters::Sample& start, const PerfCounters::Sample& end )
+	{
+		s_local.counters[phase].addDifference( start, end );
+	}
+	// the calling thread's time in each phase so far, for PerPixelCounters
+	static double localSeconds( Phase phase )  {return s_local.seconds[phase];}
+	// gives each per pixel phase its share (secondsBefore[phase] being its time when start was read)
+	// of the counts between start and end, which were read end - start seconds apart
+	static void addPerPixelCounters( const PerfCounters::Sample& start, const PerfCounters::Sample& end,
+		double seconds, const double secondsBefore[NUM_PHASES] );
+
+	// adds the calling thread's totals to the report's and starts it from zero
+	static void merge();
+	// zeroes the report's totals and the calling thread's
+	static void reset();
+	static Totals total();
+
+	// the name a phase has in the report, like "bvh_build"
+	static const char * phaseName( int phase );
+	// whether the phase runs for every pixel or more often, too often to trace, read the counters around
+	// or note the memory of
+	static bool isPerPixel( int phase )  {return phase == PRIMARY_TRACING || phase == SHADING || phase == PHOTON_GATHER;}
+	// the totals, one phase per line
+	static void print();
+
+	// writes the report as JSON: the image, seed and render time, then the time, calls, memory
+	// (and hardware counts, if there are any) for each phase, the ray counts from RenderStats
+	// and the memory in each MemoryStats category. returns false if it can't
+	static bool writeJSON( const char * filename, int width, int height, unsigned int seed, double renderSeconds );
+
+private:
+	static THREAD_LOCAL Totals s_local;
+	static Totals s_total;
+	static SpinLock s_lock; // guards s_total
+};
+
+// times the rest of the enclosing block as the given phase
+class ProfileScope
+{
+public:
+	ProfileScope( Profiler::Phase phase ) :
+		m_phase(phase),
+		m_counting(PerfCounters::isAvailable() && !Profiler::isPerPixel( phase ) && PerfCounters::read( m_counters )),
+		m_start(Timer::now()) {}
+	~ProfileScope()
+	{
+		const double end = Timer::now();
+		PerfCounters::Sample counters;
+		if( m_counting && PerfCounters::read( counters ) )
+			Profiler::addCounters( m_phase, m_counters, counters );
+		Profiler::add( m_phase, m_start, end );
+	}
+
+private:
+	Profiler::Phase m_phase;
+	PerfCounters::Sample m_counters; // at the start
+	bool m_counting;
+	double m_start;
+};
+
+// reads the hardware counters around the rest of the enclosing block, which
+// renders pixels, and shares the counts out among the per pixel phases
+class PerPixelCounters
+{
+public:
+	PerPixelCounters() : m_counting(PerfCounters::isAvailable() && PerfCounters::read( m_counters ))
+	{
+		if( !m_counting )
+			return;
+		for( int i = 0; i < Profiler::NUM_PHASES; i++ )
+			m_seconds[i] = Profiler::localSeconds( (Profiler::Phase)i );
+		m_start = Timer::now();
+	}
+	~PerPixelCounters()
+	{
+		if( !m_counting )
+			return;
+		const double seconds = Timer::now() - m_start;
+		PerfCounters::Sample counters;
+		if( PerfCounters::read( counters ) )
+			Profiler::addPerPixelCounters( m_counters, counters, seconds, m_seconds );
+	}
+
+private:
+	PerfCounters::Sample m_counters; // at the start
+	bool m_counting;
+	double m_start;
+	double m_seconds[Profiler::NUM_PHASES]; // each phase's time at the start
+};
+
+#if USE_PROFILER
+#define PROFILE_SCOPE_NAME(line) profileScope##line
+#define PROFILE_SCOPE_LINE(phase, line) ProfileScope PROFILE_SCOPE_NAME(line)( Profiler::phase )
+#define PROFILE_SCOPE(phase) PROFILE_SCOPE_LINE(phase, __LINE__)
+#define PROFILE_PER_PIXEL_COUNTERS_LINE(line) PerPixelCounters PROFILE_SCOPE_NAME(line)
+#define PROFILE_PER_PIXEL_COUNTERS() PROFILE_PER_PIXEL_COUNTERS_LINE(__LINE__)
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_PER_PIXEL_COUNTERS()
+#endif
+
+#endif // CSE168_PROFILER_H_INCLUDED
@@ -0,0 +1,46 @@
+#ifndef CSE168_PROGRESS_REPORTER_H_INCLUDED
+#define CSE168_PROGRESS_REPORTER_H_INCLUDED
+
+#include "Timer.h"
+
+#define PROGRESS_PRINT_INTERVAL 0.25 // most often (in seconds) the progress line is printed
+
+/*
+    Counts finished work units (pixels, samples, tiles...) and prints the
+    progress line with an estimate of the time left.
+
+    The estimate comes from the measured cost of the units finished so far,
+    so it follows the scene rather than assuming every row costs the same.
+    update() adds to the count atomically and only prints if enough time has
+    passed and no other thread is printing; it never waits, so whoever is
+    doing the work can call it after every unit.
+*/
+class ProgressReporter
+{
+public:
+	// total is the number of units in the whole job; alreadyDone of them were
+	// finished before this run (say, by a resumed checkpoint) and don't count
+	// towards the time estimate. startTime is when the job started (Timer::now())
+	ProgressReporter( const char * title, int total, int alreadyDone, double startTime );
+
+	void update( int numUnits );
+	// prints the final line (and a newline)
+	void done();
+
+	int unitsDone() const       {return m_done;}
+	double elapsed() const      {return Timer::now() - m_start_time;}
+
+private:
+	void print( double now );
+
+	const char * m_title;
+	int m_total;
+	int m_already_done;
+	double m_start_time;
+	double m_run_start_time; // when this run (as opposed to the whole job) started
+	double m_last_print;
+	volatile long m_done;
+	volatile long m_printing; // 1 while a thread is printing
+};
+
+#endif // CSE168_PROGRESS_REPORTER_H_INCLUDED
@@ -0,0 +1,66 @@
+#ifndef CSE168_RANDOM_H_INCLUDED
+#define CSE168_RANDOM_H_INCLUDED
+
+#include "Miro.h"
+#include <math.h>
+
+// small, fast xorshift generator. unlike rand() every instance has its own state,
+// so a sequence can be reproduced from its seed.
+class Random
+{
+public:
+	Random(unsigned int seed = 2463534242u) {setSeed(seed);}
+
+	// a zero state would make xorshift return zeros forever
+	void setSeed(unsigned int seed) {m_state = seed ? seed : 2463534242u;}
+
+	unsigned int nextUInt()
+	{
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		return m_state;
+	}
+
+	// uniform in [0,1)
+	float nextFloat()
+	{
+		// top 24 bits, so the result is exactly representable and never rounds up to 1
+		return (nextUInt() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	// maps a point of the unit square onto the unit disc with Shirley and Chiu's
+	// concentric mapping, which keeps strata that are adjacent on the square adjacent on the disc
+	static void concentricSampleDisc(float u, float v, float& dx, float& dy)
+	{
+		// map to [-1,1]^2
+		const float sx = 2.0f * u - 1.0f;
+		const float sy = 2.0f * v - 1.0f;
+
+		if( sx == 0.0f && sy == 0.0f )
+		{
+			dx = dy = 0.0f;
+			return;
+		}
+
+		float r, theta;
+		if( fabs(sx) > fabs(sy) )
+		{
+			r = sx;
+			theta = (PI / 4.0f) * (sy / sx);
+		}
+		else
+		{
+			r = sy;
+			theta = (PI / 2.0f) - (PI / 4.0f) * (sx / sy);
+		}
+
+		dx = r * cos(theta);
+		dy = r * sin(theta);
+	}
+
+private:
+	unsigned int m_state;
+};
+
+#endif // CSE168_RANDOM_H_INCLUDED
@@ -0,0 +1,49 @@
+#ifndef CSE168_REGRESSION_H_INCLUDED
+#define CSE168_REGRESSION_H_INCLUDED
+
+#define REGRESS_IMAGE_SIZE 64           // the reference scenes are rendered this many pixels square
+#define REGRESS_SEED 168                // with this seed, so a render can match its reference exactly
+#define REGRESS_MIN_PSNR 35.0           // dB; a render below this doesn't match its reference
+#define REGRESS_THROUGHPUT_TOLERANCE 40 // percent slower (in rays/sec) than the baseline a render may be
+#define REGRESS_NUM_RUNS 3              // each scene is rendered at least this many times; the fastest counts
+#define REGRESS_MIN_SECONDS 2.0         // and quick ones again until this much time has gone into them
+
+/*
+    Image and performance regression tests (-regress <dir>). Each reference
+    scene is rendered headless at REGRESS_IMAGE_SIZE with a fixed seed and
+    compared with <dir>/<scene>.pfm. A render passes if its PSNR against the
+    reference is at least REGRESS_MIN_PSNR (stochastic changes, like using
+    random numbers differently, only add noise, so they still pass), and if
+    its rays per second are within the tolerance of the baseline in
+    <dir>/<scene>.txt.
+
+    The throughput is of the rendering alone: the photon map is built first,
+    and the scene is then rendered REGRESS_NUM_RUNS times, and again until
+    REGRESS_MIN_SECONDS have gone into it, and the fastest run counts, so one
+    slow run (another process getting the CPU for a moment) doesn't fail it.
+
+    That doesn't help when the whole machine is slower for seconds at a
+    time. On a shared or virtual machine the same build's throughput has
+    varied by 30% or more either way (at REGRESS_IMAGE_SIZE, where a scene
+    renders in milliseconds to seconds), which is why the default tolerance
+    only catches large slowdowns. A quiet, dedicated machine varies much
+    less; pass a smaller -regress-tolerance there.
+
+    A scene fails without being rendered if anything it needs didn't load
+    (a mesh or material reported an error, or its BVH is empty). The
+    environment map is optional, as it is everywhere else.
+
+    A scene without a reference (or every scene, with -regress-update) has
+    its render saved as the new reference and baseline, and passes. The
+    references belong to the machine and build they were made with; the
+    throughput baseline means nothing on another.
+*/
+class Regression
+{
+public:
+	// renders and checks every reference scene. throughputTolerance is a percentage
+	// (-1 for REGRESS_THROUGHPUT_TOLERANCE). returns false if any of them failed
+	static bool run( const char * directory, bool update, float throughputTolerance );
+};
+
+#endif // CSE168_REGRESSION_H_INCLUDED
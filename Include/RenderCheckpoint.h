@@ -0,0 +1,51 @@
+#ifndef CSE168_RENDER_CHECKPOINT_H_INCLUDED
+#define CSE168_RENDER_CHECKPOINT_H_INCLUDED
+
+#include <string>
+
+class Image;
+class AccumulationBuffer;
+
+/*
+    Everything needed to pick a render back up where it stopped: which render
+    mode it was, the random seed, how far it got (pass and row), the time
+    spent so far, the image's HDR sums and sample counts, the adaptive
+    sampler's statistics and the file the photon map was saved to.
+
+    The random numbers are reseeded from (seed, pass, row) at the start of
+    every row, so the seed and the position are all the random state there
+    is; a resumed render comes out bit for bit the same as one that ran
+    straight through.
+
+    Files are written to a temporary name and then renamed over the old
+    checkpoint, so a crash in the middle of saving never loses the last one.
+    If the checkpoint itself is missing, load() falls back to the temporary
+    file.
+*/
+class RenderCheckpoint
+{
+public:
+	enum Mode
+	{
+		TILES       = 0,
+		ADAPTIVE    = 1,
+		PROGRESSIVE = 2
+	};
+
+	RenderCheckpoint();
+
+	// the image must be in HDR mode. accumulation is only written for ADAPTIVE
+	bool save( const char * filename, Image & img, const AccumulationBuffer * accumulation ) const;
+	// fails (and leaves img alone) if the file doesn't match img's size
+	bool load( const char * filename, Image & img, AccumulationBuffer * accumulation );
+
+	int mode;
+	unsigned int seed;
+	int width, height;
+	int pass;               // the pass to continue with
+	int row;                // the row to continue with (in TILES mode, the first row of a row of tiles)
+	float elapsedSeconds;   // render time spent before the checkpoint
+	std::string photonMapFile; // empty if there's no photon map
+};
+
+#endif // CSE168_RENDER_CHECKPOINT_H_INCLUDED
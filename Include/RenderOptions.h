@@ -0,0 +1,43 @@
+#ifndef CSE168_RENDER_OPTIONS_H_INCLUDED
+#define CSE168_RENDER_OPTIONS_H_INCLUDED
+
+// settings that can be changed from the command line without recompiling
+class RenderOptions
+{
+public:
+	RenderOptions();
+
+	// reads the options it recognizes out of argv (removing them, so GLUT never
+	// sees them). prints the usage and returns false if something is wrong
+	bool parse( int * argc, char * argv[] );
+	static void printUsage( const char * program );
+
+	const char * outputFile;    // -o <file>: where the ray traced image is written (.ppm, .pfm or .tga)
+	bool headless;              // -headless: ray trace straight away without a window, then exit
+	const char * checkpointFile; // -checkpoint <file>: periodically save the render's progress here
+	bool resume;                // -resume: continue from the checkpoint file instead of starting over
+	bool fixedSeed;             // -seed <n>: use n as the random seed, so renders are repeatable
+	unsigned int seed;
+	unsigned short coordinatorPort; // -coordinator <port>: hand the image's tiles out to workers connecting on port
+	const char * workerHost;    // -worker <host>:<port>: render tiles for the coordinator at host:port, then exit
+	unsigned short workerPort;
+	int cropX, cropY;           // -crop <x> <y> <width> <height>: only render this rectangle of the image,
+	int cropWidth, cropHeight;  // in pixels from its top-left corner (0 x 0 renders the whole image)
+	const char * profileFile;   // -profile <file>: write each render's phase timings and ray counts here as JSON
+	bool perfCounters;          // -perf-counters: count cycles, instructions, cache and branch misses per phase
+	const char * traceFile;     // -trace <file>: write a timeline of each render here as a Chrome trace (JSON)
+	const char * heatmapPrefix; // -heatmap <prefix>: write what each pixel cost to <prefix>_<metric>.ppm and .pfm
+	const char * benchmarkFile; // -benchmark <file>: time BVH builds and ray tracing on the Resource meshes, write the
+	                            // results here (.csv or JSON) and exit
+	const char * shadingBenchmarkFile; // -benchmark-shading <file>: time the materials and noise functions, write the
+	                                   // results here (.csv or JSON) and exit
+	const char * regressDirectory; // -regress <dir>: render the reference scenes, check them against the references
+	                               // in dir and exit (with 1 if any failed)
+	bool regressUpdate;         // -regress-update: save the renders as the new references instead
+	float regressTolerance;     // -regress-tolerance <percent>: how much slower than the baseline is still a pass
+	const char * bvhAnalysisFile; // -bvh-analysis <file.obj>: report on the scene's BVH and write its boxes here
+};
+
+extern RenderOptions g_options;
+
+#endif // CSE168_RENDER_OPTIONS_H_INCLUDED
@@ -0,0 +1,69 @@
+#ifndef CSE168_RENDER_STATS_H_INCLUDED
+#define CSE168_RENDER_STATS_H_INCLUDED
+
+#include "Atomic.h"
+
+#define USE_RENDER_STATS 1 // 0 compiles every counter out of the ray tracing code
+
+/*
+    Ray and intersection counts for a render, broken down by what the rays
+    were for.
+
+    Every thread counts into its own 64-bit counters, so counting is a plain
+    increment with no sharing between threads (and nothing overflows at the
+    ray counts a long render reaches). A thread calls merge() when it's done
+    to add its counts to the render's totals, which are what print() shows.
+*/
+class RenderStats
+{
+public:
+	enum RayType
+	{
+		CAMERA,         // pinhole eye rays (and jittered ones without depth of field)
+		DEPTH_OF_FIELD, // eye rays through a point on the lens
+		SHADOW,
+		REFLECTION,
+		REFRACTION,
+		PATH,           // path tracing bounces
+		PHOTON,         // photon map construction
+		NUM_RAY_TYPES
+	};
+
+	typedef unsigned long long Count;
+
+	struct Counters
+	{
+		Count rays[NUM_RAY_TYPES];
+		Count boundingVolumeTests;
+		Count primitiveTests;
+
+		void clear();
+		void add( const Counters& other );
+		Count totalRays() const;
+	};
+
+	static void countRay( RayType type )    {if( USE_RENDER_STATS ) s_local.rays[type]++;}
+	static void countBoundingVolumeTest()   {if( USE_RENDER_STATS ) s_local.boundingVolumeTests++;}
+	static void countPrimitiveTest()        {if( USE_RENDER_STATS ) s_local.primitiveTests++;}
+
+	// the calling thread's counts since its last merge()
+	static Counters& local()                {return s_local;}
+	// adds the calling thread's counts to the totals and starts it counting from zero
+	static void merge();
+	// adds counts from somewhere else (a worker process, say) to the totals
+	static void add( const Counters& counters );
+	// zeroes the totals and the calling thread's counts
+	static void reset();
+	static Counters total();
+
+	static const char * rayTypeName( int type );
+	// the totals, one ray type per line
+	static void print();
+
+private:
+	static THREAD_LOCAL Counters s_local;
+	static Counters s_total;
+	static SpinLock s_lock; // guards s_total
+};
+
+#endif // CSE168_RENDER_STATS_H_INCLUDED
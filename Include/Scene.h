@@ -6,6 +6,11 @@
 #include "PointLight.h"
 #include "BVH.h"
 #include "PhotonMap.h"
+#include "Random.h"
+#include "AccumulationBuffer.h"
+#include "RenderCheckpoint.h"
+#include "RenderStats.h"
+#include "CostMap.h"
 
 class Camera;
 class Image;
@@ -15,11 +20,28 @@ class Image;
 #define USE_PATH_TRACING 0
 #define NUM_PATH_TRACING_SAMPLES 5
 #define USE_DEPTH_OF_FIELD 1
-#define NUM_DEPTH_OF_FIELD_SAMPLES 30
+#define NUM_DEPTH_OF_FIELD_SAMPLES 30 // most lens samples per pixel; rounded down to a square number for stratification
 #define USE_PHOTON_MAPPING 1
 #define NUM_PHOTONS 500000
 #define MAX_PHOTON_BOUNCES 5
 #define MAX_PHOTON_DISTANCE 50
+#define TILE_SIZE 16 // the image is rendered in square tiles of this many pixels
+// adaptive sampling: every pixel gets jittered samples in passes until the relative
+// standard error of its mean luminance is under the threshold (or it hits the cap)
+#define USE_ADAPTIVE_SAMPLING 0
+#define ADAPTIVE_MIN_SAMPLES 4
+#define ADAPTIVE_MAX_SAMPLES 256
+#define ADAPTIVE_SAMPLES_PER_PASS 8 // most samples a pixel gets in one pass after the first
+#define ADAPTIVE_ERROR_THRESHOLD 0.02f
+#define ADAPTIVE_ERROR_FLOOR 0.1f // luminance the error of darker pixels is measured against
+#define ADAPTIVE_TIME_LIMIT 0 // seconds; 0 means no limit
+// progressive rendering: one jittered sample per pixel over the whole frame per pass,
+// averaged in the image's HDR buffer, until the time budget or sample target is reached
+// (set at least one of the two). the output file (-o) is rewritten after every pass
+#define USE_PROGRESSIVE_RENDERING 0
+#define PROGRESSIVE_TIME_BUDGET 0 // seconds; 0 means no budget
+#define PROGRESSIVE_SAMPLE_TARGET 64 // samples per pixel; 0 means no target
+#define CHECKPOINT_INTERVAL 60 // seconds between checkpoints (-checkpoint)
 
 class Scene
 {
@@ -30,6 +52,14 @@ public:
     void addObject(Object* pObj)        {m_objects.push_back(pObj);}
     const Objects* objects() const      {return &m_objects;}
 
+    // the mesh's triangles go straight into the BVH; no Triangle objects are created
+    void addMesh(TriangleMesh* pMesh)   {m_meshes.push_back(pMesh);}
+    const TriangleMeshes* meshes() const {return &m_meshes;}
+
+    // a mesh only Instances reference. the scene deletes it, but its triangles
+    // stay out of the top-level BVH; the Instances bring them in
+    void addInstancedMesh(TriangleMesh* pMesh) {m_instanced_meshes.push_back(pMesh);}
+
     void addLight(PointLight* pObj)     {m_lights.push_back(pObj);}
     const Lights* lights() const        {return &m_lights;}
 
@@ -38,23 +68,79 @@ public:
 	const int mapHeight() const {return m_map_height;}
 
 	const PhotonMap* photonMap() const {return m_photon_map;}
+	const BVH& bvh() const {return m_bvh;}
 
     void preCalc();
     void openGL(Camera *cam);
 
     void raytraceImage(Camera *cam, Image *img);
-    bool trace(HitInfo& minHit, const Ray& ray,
+    // seeds the random numbers and builds the photon map (if it isn't already), then
+    // renderTile() can be used on its own. raytraceImage() does this itself
+    void setupRender(unsigned int seed);
+    // renders one tile (at most TILE_SIZE x TILE_SIZE) of the image at a sample per pixel.
+    // only the pixels inside the render window are set
+    void renderTile(Camera *cam, Image *img, int tileX, int tileY, int tileWidth, int tileHeight);
+    // limits ray tracing to the width x height rectangle at (x, y), in pixels from img's
+    // top-left corner (as shown in the window). the rest of the image is left alone.
+    // a width or height of 0 goes back to rendering the whole image. the rectangle is cut
+    // down to the image; if it starts outside it, there's no crop window and it returns false
+    bool setCropWindow(int x, int y, int width, int height, const Image *img);
+    bool hasCropWindow() const {return m_crop_width > 0 && m_crop_height > 0;}
+    // the part of img that gets rendered, [x0, x1) x [y0, y1) in image pixels (row 0 at the bottom)
+    void renderWindow(const Image *img, int& x0, int& y0, int& x1, int& y1) const;
+    // how many of the tile's pixels are inside the render window
+    int tilePixelsInWindow(const Image *img, int tileX, int tileY, int tileWidth, int tileHeight) const;
+    // shows rows [y0, y1) of the image in the window (unless there is none)
+    void displayRows(Image *img, int y0, int y1);
+    // type is what the ray is for, as counted in the render's statistics
+    bool trace(HitInfo& minHit, const Ray& ray, RenderStats::RayType type,
                float tMin = 0.0f, float tMax = MIRO_TMAX) const;
 
 protected:
+	// one sample per pixel center, a tile at a time. each finished row of tiles is
+	// streamed to the output file (-o)
+	void renderTiles(Camera *cam, Image *img, double startTime);
+	// jittered samples in passes, concentrated on the pixels that are still noisy
+	void renderAdaptive(Camera *cam, Image *img, double startTime);
+	// one jittered sample per pixel per pass, refining the whole image each time
+	void renderProgressive(Camera *cam, Image *img, double startTime);
+
+	// which RenderCheckpoint::Mode the USE_ flags select
+	static int renderMode();
+	void buildPhotonMap();
+	// reseeds rand() and m_sample_random for the given row or tile (x, y) of the given pass
+	void reseed(int pass, int x, int y);
+	// saves a checkpoint saying the render continues at (pass, row), if -checkpoint was
+	// given and CHECKPOINT_INTERVAL has passed since the last one (or force is set)
+	void saveCheckpoint(Image *img, int pass, int row, double startTime, bool force);
+
+	// writes the whole image to the output file (-o), if there is one
+	void writeOutput(Image *img);
+
+	// returns the pixel's color through an eye ray: with depth of field, lens rays
+	// through the same point on the focal plane, as many as the pixel's blur needs
+	Vector3 shadePixel(Camera *cam, const Ray& ray);
+	// traces one randomly jittered eye ray through pixel (x, y) and returns its color
+	Vector3 shadeSample(Camera *cam, int x, int y, int imageWidth, int imageHeight);
+	Vector3 shadeRay(const Ray& ray, RenderStats::RayType type);
+	// the color seen along a ray that hits nothing
+	Vector3 shadeMiss(const Ray& ray) const;
+
     Objects m_objects;
+    TriangleMeshes m_meshes;
+    TriangleMeshes m_instanced_meshes;
     BVH m_bvh;
     Lights m_lights;
-	int m_num_rays_traced;
 	Vector3 * m_environment_map;
 	int m_map_width;
 	int m_map_height;
 	PhotonMap * m_photon_map;
+	Random m_sample_random; // jitters pixel and depth of field lens samples
+	AccumulationBuffer m_accumulation;
+	RenderCheckpoint m_checkpoint; // the seed and progress of the current render
+	double m_last_checkpoint; // Timer::now() when the last checkpoint was saved
+	int m_crop_x, m_crop_y, m_crop_width, m_crop_height; // from the top-left corner
+	CostMap m_cost_map; // what each pixel cost (-heatmap); empty when it isn't being measured
 };
 
 extern Scene * g_scene;
@@ -0,0 +1,35 @@
+#ifndef CSE168_SHADING_BENCHMARK_H_INCLUDED
+#define CSE168_SHADING_BENCHMARK_H_INCLUDED
+
+#define SHADING_BENCHMARK_NUM_HITS 4096         // each material shades this many synthetic hits
+#define SHADING_BENCHMARK_NUM_NOISE_POINTS 262144 // each noise function is evaluated at this many points
+#define SHADING_BENCHMARK_NUM_RUNS 3            // each is timed this many times; the fastest counts
+#define SHADING_BENCHMARK_SEED 4321             // so every run uses the same hits and points
+
+/*
+    Shading microbenchmark (-benchmark-shading). Each material (Lambert,
+    Stone, Sand, SpecularReflector and SpecularRefractor) shades the same
+    stream of synthetic hits: random points in the teapot's bounds, with
+    random normals, seen from random directions. That's done twice:
+
+        stub        in a scene with nothing but the light, so every shadow,
+                    reflection and refraction ray misses straight away and
+                    only the shading itself is timed
+        real        in a scene with the teapot in it, so the rays the
+                    material traces cost what they would in a render
+
+    The noise functions the materials use (CustomizablePerlinNoise::Get,
+    PerlinNoise::noise and WorleyNoise::noise3D) are also timed on their
+    own. Everything is reported in ns per evaluation, with the rays each
+    shade traced (and, with -perf-counters, the IPC and the cache and branch
+    misses per evaluation), to show which shaders are worth making faster.
+*/
+class ShadingBenchmark
+{
+public:
+	// runs the benchmark, prints the results and writes them to filename, as
+	// CSV if it ends in .csv and otherwise JSON. returns false if it can't
+	static bool run( const char * filename );
+};
+
+#endif // CSE168_SHADING_BENCHMARK_H_INCLUDED
@@ -0,0 +1,57 @@
+#ifndef CSE168_SOCKET_H_INCLUDED
+#define CSE168_SOCKET_H_INCLUDED
+
+#include <stddef.h>
+#include <vector>
+
+#ifdef WIN32
+#include <winsock2.h>
+typedef SOCKET SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+/*
+    A blocking TCP socket: Winsock on Windows, BSD sockets everywhere else.
+    Only what the distributed renderer needs, so there's no non-blocking I/O;
+    select() is used to find out which sockets have something to read.
+*/
+class Socket
+{
+public:
+	// initializes Winsock (does nothing elsewhere). call once before using any sockets
+	static bool startup();
+
+	Socket();
+	~Socket();
+
+	// starts listening for connections on port (on all interfaces)
+	bool listen( unsigned short port );
+	// waits for the next connection; returns 0 on failure. the caller deletes it
+	Socket* accept();
+	bool connect( const char * host, unsigned short port );
+	void close();
+
+	bool isOpen() const;
+	// the other end's address as "a.b.c.d:port"
+	const char * peerName() const { return m_peer_name; }
+
+	// these keep going until all of the bytes are sent / received, and fail if the
+	// connection is closed or breaks first
+	bool sendAll( const void * data, size_t numBytes );
+	bool recvAll( void * data, size_t numBytes );
+
+	// waits up to timeoutMs for any of sockets to become readable (or closed) and
+	// returns them in ready. returns false on error
+	static bool select( const std::vector<Socket*>& sockets, int timeoutMs, std::vector<Socket*>& ready );
+
+private:
+	// no copying; a socket has one owner
+	Socket( const Socket& );
+	Socket& operator=( const Socket& );
+
+	SocketHandle m_handle;
+	char m_peer_name[32];
+};
+
+#endif // CSE168_SOCKET_H_INCLUDED
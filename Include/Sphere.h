@@ -20,6 +20,9 @@ public:
     virtual bool intersect(HitInfo& result, const Ray& ray,
                            float tMin = 0.0f, float tMax = MIRO_TMAX);
 
+    virtual void getBounds(Vector3& vMin, Vector3& vMax) const;
+    virtual Vector3 getMidPoint() const {return m_center;}
+
 protected:
     Vector3 m_center;
     float m_radius;
@@ -0,0 +1,26 @@
+#ifndef CSE168_TIMER_H_INCLUDED
+#define CSE168_TIMER_H_INCLUDED
+
+/*
+    Monotonic wall clock time in seconds. Unlike clock(), which counts the
+    process's CPU time on some platforms (and so stops while it sleeps or
+    waits, and runs fast with several threads), this never goes backwards
+    and keeps pace with the clock on the wall.
+*/
+class Timer
+{
+public:
+	Timer() {reset();}
+
+	void reset()            {m_start = now();}
+	// seconds since the timer was made (or reset)
+	double elapsed() const  {return now() - m_start;}
+
+	// seconds since some fixed point in the past
+	static double now();
+
+private:
+	double m_start;
+};
+
+#endif // CSE168_TIMER_H_INCLUDED
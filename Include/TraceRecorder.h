@@ -0,0 +1,120 @@
+#ifndef CSE168_TRACE_RECORDER_H_INCLUDED
+#define CSE168_TRACE_RECORDER_H_INCLUDED
+
+#include "Atomic.h"
+#include "Timer.h"
+#include <vector>
+#include <string>
+
+#define USE_TRACING 1 // 0 compiles event tracing out (-trace is then ignored)
+#define TRACE_RATE_INTERVAL 0.1 // seconds between samples of a TraceRate
+
+/*
+    Records a timeline of the render (the profiler's phases, every tile and
+    pass, rays per second) and writes it as a Chrome trace, which chrome://tracing
+    or ui.perfetto.dev can open.
+
+    Nothing is recorded until enable() is called (by -trace). Each thread
+    appends its events to a buffer of its own, so recording never takes a
+    lock; the buffers are only gathered up by write() after the render.
+    Events are drawn in lanes: every thread gets one, and newLane() makes
+    more for work that happens elsewhere, like a distributed worker's tiles.
+
+    Names, categories and argument names must be string literals (or otherwise
+    outlive the recorder); they're stored as pointers, not copied.
+*/
+class TraceRecorder
+{
+public:
+	// starts recording; times in the trace are measured from here
+	static void enable();
+	static bool isEnabled()     {return USE_TRACING && s_enabled;}
+
+	// something that took from start to end (Timer::now() values) on the calling thread
+	static void span( const char * name, const char * category, double start, double end,
+		const char * arg0Name = 0, int arg0 = 0, const char * arg1Name = 0, int arg1 = 0 )
+	{
+		if( isEnabled() )
+			record( 'X', threadLane(), name, category, start, end - start, 0.0, arg0Name, arg0, arg1Name, arg1 );
+	}
+	// the same, drawn in the given lane (from newLane()) instead of the thread's
+	static void spanOnLane( int lane, const char * name, const char * category, double start, double end,
+		const char * arg0Name = 0, int arg0 = 0, const char * arg1Name = 0, int arg1 = 0 )
+	{
+		if( isEnabled() )
+			record( 'X', lane, name, category, start, end - start, 0.0, arg0Name, arg0, arg1Name, arg1 );
+	}
+	// a value to graph over time, such as rays per second
+	static void counter( const char * name, double time, double value )
+	{
+		if( isEnabled() )
+			record( 'C', threadLane(), name, "counter", time, 0.0, value, 0, 0, 0, 0 );
+	}
+
+	// a new lane with the given name, for spanOnLane()
+	static int newLane( const std::string & name );
+	// the calling thread's lane (made the first time it's asked for)
+	static int threadLane();
+
+	// writes every thread's events to a Chrome trace JSON file and clears them.
+	// returns false if it can't
+	static bool write( const char * filename );
+
+private:
+	struct Event
+	{
+		char type;          // 'X' for a span, 'C' for a counter
+		int lane;
+		const char * name;
+		const char * category;
+		double start;       // seconds since enable()
+		double duration;
+		double value;       // counters only
+		const char * argNames[2];
+		int args[2];
+	};
+
+	struct ThreadBuffer
+	{
+		int lane;
+		std::vector<Event> events;
+	};
+
+	static void record( char type, int lane, const char * name, const char * category, double start, double duration,
+		double value, const char * arg0Name, int arg0, const char * arg1Name, int arg1 );
+
+	static bool s_enabled;
+	static double s_origin;
+	static THREAD_LOCAL ThreadBuffer * s_buffer;
+	// these are only touched when a thread or lane is added, or by write()
+	static std::vector<ThreadBuffer*> s_buffers;
+	static std::vector<std::string> s_lane_names;
+	static SpinLock s_lock;
+};
+
+// graphs how fast a running total (like the rays traced so far) goes up,
+// as a counter in the trace sampled every TRACE_RATE_INTERVAL seconds
+class TraceRate
+{
+public:
+	TraceRate( const char * name, double total ) : m_name(name), m_time(Timer::now()), m_total(total) {}
+
+	void update( double total )
+	{
+		if( !TraceRecorder::isEnabled() )
+			return;
+		const double now = Timer::now();
+		if( now - m_time < TRACE_RATE_INTERVAL )
+			return;
+		TraceRecorder::counter( m_name, now, ( total - m_total ) / ( now - m_time ) );
+		m_time = now;
+		m_total = total;
+	}
+
+private:
+	const char * m_name;
+	double m_time;      // when the last sample was taken
+	double m_total;     // and what the total was then
+};
+
+#endif // CSE168_TRACE_RECORDER_H_INCLUDED
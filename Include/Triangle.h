@@ -2,14 +2,19 @@
 #define CSE168_TRIANGLE_H_INCLUDED
 
 #include "Object.h"
+#include "MemoryStats.h"
 
 #define USE_PLUCKER_COORDS 1
 
 /*
     The Triangle class stores a pointer to a mesh and an index into its
     triangle array. The mesh stores all data needed by this Triangle.
+
+    Meshes added to the scene with Scene::addMesh don't need Triangle objects
+    at all; the BVH addresses their triangles directly through the static
+    intersect/bounds functions below.
 */
-class Triangle : public Object
+class Triangle : public Object, public MemoryTracked<MemoryStats::TRIANGLES>
 {
 public:
     Triangle(TriangleMesh * m = 0, unsigned int i = 0);
@@ -25,14 +30,21 @@ public:
     virtual bool intersect(HitInfo& result, const Ray& ray,
                            float tMin = 0.0f, float tMax = MIRO_TMAX);
 
-	Vector3 getMidPoint();
+	virtual void getBounds(Vector3& vMin, Vector3& vMax) const;
+	virtual Vector3 getMidPoint() const;
+
+	// intersect/bound triangle i of a mesh. intersect doesn't set result.material.
+	static bool intersect(HitInfo& result, const Ray& ray, TriangleMesh* mesh, unsigned int i,
+	                      float tMin, float tMax);
+	static void getBounds(TriangleMesh* mesh, unsigned int i, Vector3& vMin, Vector3& vMax);
+	static Vector3 getMidPoint(TriangleMesh* mesh, unsigned int i);
     
 protected:
     TriangleMesh* m_mesh;
     unsigned int m_index;
 
-	void calcPluckerCoords(Vector3 linePt, Vector3 lineDir, Vector3 pluckerCoordsOut[2]);
-	float permutedInnerProduct(Vector3 pluckerR[2], Vector3 pluckerS[2]);
+	static void calcPluckerCoords(Vector3 linePt, Vector3 lineDir, Vector3 pluckerCoordsOut[2]);
+	static float permutedInnerProduct(Vector3 pluckerR[2], Vector3 pluckerS[2]);
 };
 
 #endif // CSE168_TRIANGLE_H_INCLUDED
@@ -3,6 +3,9 @@
 
 #include "Matrix4x4.h"
 #include "Material.h"
+#include <vector>
+
+class BVH;
 
 class TriangleMesh
 {
@@ -32,17 +35,33 @@ public:
         float x, y;
     };
 
-	Material ** materials()  {return m_materials;}
     Vector3* vertices()     {return m_vertices;}
     Vector3* normals()      {return m_normals;}
     TupleI3* vIndices()     {return m_vertexIndices;}
     TupleI3* nIndices()     {return m_normalIndices;}
     int numTris()           {return m_numTris;}
 
+    // faces that didn't get a material from the OBJ file use this one
+    void setMaterial(const Material* m)  {m_materialTable[0] = m;}
+    const Material* getMaterial(unsigned int i) const
+        {return m_materialTable[m_materialIndices ? m_materialIndices[i] : 0];}
+
+    void renderGL();
+
+    // builds a BVH over this mesh's triangles in object space, so that
+    // it can be shared by every Instance of the mesh
+    void buildBVH(const Material * material);
+    BVH * bvh()             {return m_bvh;}
+
 protected:
     void loadObj(FILE* fp, const Matrix4x4& ctm);
+    // adds the arrays just allocated for the given counts to MemoryStats
+    void countArrays(size_t numVertices, size_t numNormals, size_t numTexCoords, size_t numFaces, bool materialIndices);
 
-	Material ** m_materials;
+    // per-face index into m_materialTable. entry 0 is the mesh's default material;
+    // the rest are the distinct materials named by the OBJ file's usemtl lines
+    unsigned short* m_materialIndices;
+    std::vector<const Material*> m_materialTable;
 
     Vector3* m_normals;
     Vector3* m_vertices;
@@ -52,7 +71,12 @@ protected:
     TupleI3* m_vertexIndices;
     TupleI3* m_texCoordIndices;
     unsigned int m_numTris;
+    size_t m_vertexBytes, m_normalBytes, m_indexBytes; // as counted in MemoryStats
+
+    BVH * m_bvh;
 };
 
+typedef std::vector<TriangleMesh*> TriangleMeshes;
+
 
 #endif // CSE168_TRIANGLE_MESH_H_INCLUDED
@@ -0,0 +1,116 @@
+#include "AccumulationBuffer.h"
+#include "MemoryStats.h"
+#include "DebugMem.h"
+#include <math.h>
+
+AccumulationBuffer::AccumulationBuffer() : m_pixels(0), m_width(0), m_height(0)
+{
+}
+
+AccumulationBuffer::~AccumulationBuffer()
+{
+	if( m_pixels )
+	{
+		delete [] m_pixels;
+		MemoryStats::remove( MemoryStats::IMAGES, m_width * m_height * sizeof(Pixel) );
+	}
+}
+
+void
+AccumulationBuffer::resize( int width, int height )
+{
+	if( m_pixels && width == m_width && height == m_height )
+	{
+		clear();
+		return;
+	}
+
+	if( m_pixels )
+	{
+		delete [] m_pixels;
+		MemoryStats::remove( MemoryStats::IMAGES, m_width * m_height * sizeof(Pixel) );
+	}
+
+	m_pixels = new Pixel[width*height];
+	MemoryStats::add( MemoryStats::IMAGES, width * height * sizeof(Pixel) );
+	m_width = width;
+	m_height = height;
+	clear();
+}
+
+void
+AccumulationBuffer::clear()
+{
+	for( int i = 0; i < m_width*m_height; i++ )
+	{
+		m_pixels[i].sum.set( 0.0f, 0.0f, 0.0f );
+		m_pixels[i].lumSum = 0.0f;
+		m_pixels[i].lumSqSum = 0.0f;
+		m_pixels[i].numSamples = 0;
+		m_pixels[i].converged = false;
+	}
+}
+
+void
+AccumulationBuffer::addSample( int x, int y, const Vector3& color )
+{
+	Pixel & pixel = m_pixels[y*m_width+x];
+	const float lum = luminance( color );
+
+	pixel.sum += color;
+	pixel.lumSum += lum;
+	pixel.lumSqSum += lum*lum;
+	pixel.numSamples++;
+}
+
+Vector3
+AccumulationBuffer::mean( int x, int y ) const
+{
+	const Pixel & pixel = m_pixels[y*m_width+x];
+	if( pixel.numSamples == 0 )
+		return Vector3( 0.0f, 0.0f, 0.0f );
+
+	return pixel.sum / (float)pixel.numSamples;
+}
+
+float
+AccumulationBuffer::variance( int x, int y ) const
+{
+	const Pixel & pixel = m_pixels[y*m_width+x];
+	if( pixel.numSamples < 2 )
+		return 0.0f;
+
+	const float n = (float)pixel.numSamples;
+	const float meanLum = pixel.lumSum / n;
+
+	// E[x^2] - E[x]^2 can come out slightly negative from round off
+	const float var = ( pixel.lumSqSum - n*meanLum*meanLum ) / ( n - 1.0f );
+	return var > 0.0f ? var : 0.0f;
+}
+
+float
+AccumulationBuffer::relativeError( int x, int y, float errorFloor ) const
+{
+	const Pixel & pixel = m_pixels[y*m_width+x];
+	if( pixel.numSamples < 2 )
+		return FLT_MAX;
+
+	const float meanLum = pixel.lumSum / (float)pixel.numSamples;
+	const float standardError = sqrt( variance( x, y ) / (float)pixel.numSamples );
+
+	return standardError / ( meanLum > errorFloor ? meanLum : errorFloor );
+}
+
+bool
+AccumulationBuffer::write( FILE * fp ) const
+{
+	const size_t count = m_width*m_height;
+	return fwrite( m_pixels, sizeof(Pixel), count, fp ) == count;
+}
+
+bool
+AccumulationBuffer::read( FILE * fp )
+{
+	const size_t count = m_width*m_height;
+	return fread( m_pixels, sizeof(Pixel), count, fp ) == count;
+}
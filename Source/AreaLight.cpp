@@ -1,7 +1,7 @@
 #include "AreaLight.h"
+#include "Random.h"
 #include <assert.h>
 #include <stdlib.h>
-#include <time.h>
 
 unsigned int AreaLight::NUM_SAMPLES = 20;
 
@@ -38,7 +38,7 @@ AreaLight::getHitRatio( Vector3 hitPoint, const Scene& scene )
 		sampleRay.d /= magnitude;
 
 		HitInfo sampleHit;
-		if( scene.trace( sampleHit, sampleRay, epsilon, magnitude ) )
+		if( scene.trace( sampleHit, sampleRay, RenderStats::SHADOW, epsilon, magnitude ) )
 		{
 			bool inShadow = true;
 			bool hitSomething = true;
@@ -52,7 +52,7 @@ AreaLight::getHitRatio( Vector3 hitPoint, const Scene& scene )
 				// see if we hit anything else; start tracing from last hit point
 				sampleRay.o = sampleHit.P;
 				magnitude = ( m_samples[i] - sampleRay.o ).length();
-				hitSomething = scene.trace( sampleHit, sampleRay, epsilon, magnitude );
+				hitSomething = scene.trace( sampleHit, sampleRay, RenderStats::SHADOW, epsilon, magnitude );
 
 				// if we hit something, put shadow flag back on (if it's refractive, it'll get turned off on the next loop)
 				if( hitSomething )
@@ -74,13 +74,14 @@ AreaLight::preCalc()
 
 	Vector3 axisOrigin = m_position - 0.5 * m_axis1 - 0.5 * m_axis2;
 
-	srand(time(0));
+	// a fixed seed, so the light's points (and the render) don't change from run to run
+	Random random( AREA_LIGHT_SEED );
 	for( unsigned int i = 0; i < NUM_SAMPLES; i++ )
 	{
 		float u, v;
 		
-		u = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
-		v = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
+		u = random.nextFloat(); // yields random value in range [0,1)
+		v = random.nextFloat(); // yields random value in range [0,1)
 
 		m_samples[i] = axisOrigin + u * m_axis1 + v * m_axis2;
 	}
@@ -132,6 +133,6 @@ Vector3
 AreaLight::getRandomLightPoint() const
 {
 	assert( m_samples );
-	int sampleIndex = rand() / NUM_SAMPLES;
+	int sampleIndex = rand() % NUM_SAMPLES;
 	return m_samples[sampleIndex];
 }
\ No newline at end of file
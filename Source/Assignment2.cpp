@@ -151,170 +151,135 @@ Assignment2::makeBunny20Scene()
     xform2 *= AssignmentHelper::rotate(110, 0, 1, 0);
     xform2 *= AssignmentHelper::scale(.6, 1, 1.1);
 
+    // every bunny shares one copy of the mesh and its BVH, placed by its own transform.
+    // the scene takes the mesh when the first instance is added
+    TriangleMesh * bunny = new TriangleMesh;
+    bunny->load("Resource\\bunny.obj");
+
 
     // bunny 1
     xform.setIdentity();
     xform *= AssignmentHelper::scale(0.3, 2.0, 0.7);
     xform *= AssignmentHelper::translate(-1, .4, .3);
     xform *= AssignmentHelper::rotate(25, .3, .1, .6);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 2
     xform.setIdentity();
     xform *= AssignmentHelper::scale(.6, 1.2, .9);
     xform *= AssignmentHelper::translate(7.6, .8, .6);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 3
     xform.setIdentity();
     xform *= AssignmentHelper::translate(.7, 0, -2);
     xform *= AssignmentHelper::rotate(120, 0, .6, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 4
     xform.setIdentity();
     xform *= AssignmentHelper::translate(3.6, 3, -1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 5
     xform.setIdentity();
     xform *= AssignmentHelper::translate(-2.4, 2, 3);
     xform *= AssignmentHelper::scale(1, .8, 2);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 6
     xform.setIdentity();
     xform *= AssignmentHelper::translate(5.5, -.5, 1);
     xform *= AssignmentHelper::scale(1, 2, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 7
     xform.setIdentity();
     xform *= AssignmentHelper::rotate(15, 0, 0, 1);
     xform *= AssignmentHelper::translate(-4, -.5, -6);
     xform *= AssignmentHelper::scale(1, 2, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 8
     xform.setIdentity();
     xform *= AssignmentHelper::rotate(60, 0, 1, 0);
     xform *= AssignmentHelper::translate(5, .1, 3);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 9
     xform.setIdentity();
     xform *= AssignmentHelper::translate(-3, .4, 6);
     xform *= AssignmentHelper::rotate(-30, 0, 1, 0);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 10
     xform.setIdentity();
     xform *= AssignmentHelper::translate(3, 0.5, -2);
     xform *= AssignmentHelper::rotate(180, 0, 1, 0);
     xform *= AssignmentHelper::scale(1.5, 1.5, 1.5);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 11
     xform = xform2;
     xform *= AssignmentHelper::scale(0.3, 2.0, 0.7);
     xform *= AssignmentHelper::translate(-1, .4, .3);
     xform *= AssignmentHelper::rotate(25, .3, .1, .6);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 12
     xform = xform2;
     xform *= AssignmentHelper::scale(.6, 1.2, .9);
     xform *= AssignmentHelper::translate(7.6, .8, .6);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 13
     xform = xform2;
     xform *= AssignmentHelper::translate(.7, 0, -2);
     xform *= AssignmentHelper::rotate(120, 0, .6, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 14
     xform = xform2;
     xform *= AssignmentHelper::translate(3.6, 3, -1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 15
     xform = xform2;
     xform *= AssignmentHelper::translate(-2.4, 2, 3);
     xform *= AssignmentHelper::scale(1, .8, 2);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 16
     xform = xform2;
     xform *= AssignmentHelper::translate(5.5, -.5, 1);
     xform *= AssignmentHelper::scale(1, 2, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 17
     xform = xform2;
     xform *= AssignmentHelper::rotate(15, 0, 0, 1);
     xform *= AssignmentHelper::translate(-4, -.5, -6);
     xform *= AssignmentHelper::scale(1, 2, 1);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 18
     xform = xform2;
     xform *= AssignmentHelper::rotate(60, 0, 1, 0);
     xform *= AssignmentHelper::translate(5, .1, 3);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 19
     xform = xform2;
     xform *= AssignmentHelper::translate(-3, .4, 6);
     xform *= AssignmentHelper::rotate(-30, 0, 1, 0);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
     // bunny 20
     xform = xform2;
     xform *= AssignmentHelper::translate(3, 0.5, -2);
     xform *= AssignmentHelper::rotate(180, 0, 1, 0);
     xform *= AssignmentHelper::scale(1.5, 1.5, 1.5);
-    mesh = new TriangleMesh;
-    mesh->load("Resource\\bunny.obj", xform);
-    AssignmentHelper::addMeshTrianglesToScene(mesh, material);
+    AssignmentHelper::addMeshInstanceToScene(bunny, material, xform);
 
 
     // create the floor triangle
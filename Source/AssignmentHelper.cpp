@@ -3,23 +3,25 @@
 void
 AssignmentHelper::addMeshTrianglesToScene(TriangleMesh * mesh, Material * material)
 {
-	// create all the triangles in the bunny mesh and add to the scene
-	for (int i = 0; i < mesh->numTris(); ++i)
-	{
-		Triangle* t = new Triangle;
-		t->setIndex(i);
-		t->setMesh(mesh);
-		
-		if( t->getMesh()->materials() && t->getMesh()->materials()[i] )
-		{
-			Material * storedMaterial = t->getMesh()->materials()[i];
-			t->setMaterial( storedMaterial );
-		}
-		else
-			t->setMaterial(material); 
+	// the scene's BVH addresses the mesh's triangles directly. faces that were
+	// given a material by the OBJ file keep it; the rest use this one.
+	mesh->setMaterial(material);
+	g_scene->addMesh(mesh);
+}
 
-		g_scene->addObject(t);
+void
+AssignmentHelper::addMeshInstanceToScene(TriangleMesh * mesh, Material * material, const Matrix4x4 & xform)
+{
+	// the mesh's own BVH is built the first time it is instanced and shared from then on.
+	// material only applies to faces without a material of their own, so it is
+	// fixed by the first call for a given mesh. the scene takes the mesh then too
+	if( !mesh->bvh() )
+	{
+		mesh->buildBVH( material );
+		g_scene->addInstancedMesh( mesh );
 	}
+
+	g_scene->addObject( new Instance( mesh, xform ) );
 }
 
 Matrix4x4
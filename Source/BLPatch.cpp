@@ -4,7 +4,7 @@
 #include "Console.h"
 #include "DebugMem.h"
 
-#include "BVH.h"
+#include "RenderStats.h"
 
 BLPatch::BLPatch( Vector3 ptA, Vector3 ptB, Vector3 ptC, Vector3 ptD )
 {
@@ -238,6 +238,27 @@ BLPatch::intersect(HitInfo& result, const Ray& ray,
 	//result.material = new Lambert(Vector3(fabs(result.N.x), fabs(result.N.y), fabs(result.N.z)));
 	result.material = new Lambert(Vector3(u[useIndex],v[useIndex],1-v[useIndex]));
 
-	BVH::intersectPrimitive();
+	RenderStats::countPrimitiveTest();
 	return true;
 }
+
+void
+BLPatch::getBounds(Vector3& vMin, Vector3& vMax) const
+{
+	vMin = vMax = m_verts[0];
+	for( int i = 1; i < 4; i++ )
+	{
+		vMin.x = std::min( vMin.x, m_verts[i].x );
+		vMin.y = std::min( vMin.y, m_verts[i].y );
+		vMin.z = std::min( vMin.z, m_verts[i].z );
+		vMax.x = std::max( vMax.x, m_verts[i].x );
+		vMax.y = std::max( vMax.y, m_verts[i].y );
+		vMax.z = std::max( vMax.z, m_verts[i].z );
+	}
+}
+
+Vector3
+BLPatch::getMidPoint() const
+{
+	return ( m_verts[0] + m_verts[1] + m_verts[2] + m_verts[3] ) / 4;
+}
@@ -2,58 +2,92 @@
 #include "BoundingBox.h"
 #include "Ray.h"
 #include "Triangle.h"
-#include "TriangleMesh.h"
 #include "Console.h"
+#include "Profiler.h"
 #include "DebugMem.h"
 
 #include <assert.h>
-#include <time.h>
-
-int BVH::BVIntersections = 0;
-int BVH::PrimIntersections = 0;
 
 BVH::BVH() :
-m_numLeaves(0), m_numNodes(0), m_objects(NULL), m_BVHRoot(NULL)
+m_numLeaves(0), m_numNodes(0), m_BVHRoot(NULL), m_nodeArena(MemoryStats::BVH_NODES),
+m_scratchArena(MemoryStats::BVH_BUILD), m_countedPrimitiveBytes(0)
 {
 }
 
 BVH::~BVH() 
 {
-	delete m_BVHRoot;
+	// the objects and meshes belong to whoever built us. the volumes are freed
+	// along with the node arena.
 	m_BVHRoot = NULL;
+	MemoryStats::remove( MemoryStats::BVH_NODES, m_countedPrimitiveBytes );
 }
 
 void
-BVH::build(Objects * objs)
+BVH::build(Objects * objs, TriangleMeshes * meshes)
 {
-	clock_t clockStart = clock();
+	PROFILE_SCOPE(BVH_BUILD);
+	Timer timer;
+
+	if( objs )
+		m_objects = *objs;
+	if( meshes )
+		m_meshes = *meshes;
 
 	if( USE_BVH )
 	{
+		// gather a reference to every primitive we need to bound
+		size_t numPrims = m_objects.size();
+		for( size_t i = 0; i < m_meshes.size(); i++ )
+			numPrims += m_meshes[i]->numTris();
+		m_primitives.reserve( numPrims );
+
+		PrimitiveRef prim;
+		for( size_t i = 0; i < m_objects.size(); i++ )
+		{
+			prim.mesh = PrimitiveRef::OBJECT;
+			prim.index = i;
+			m_primitives.push_back( prim );
+		}
+		for( size_t i = 0; i < m_meshes.size(); i++ )
+		{
+			for( int j = 0; j < m_meshes[i]->numTris(); j++ )
+			{
+				prim.mesh = i;
+				prim.index = j;
+				m_primitives.push_back( prim );
+			}
+		}
+
 		// don't build anything if the scene is empty
-		if( !objs->empty() )
+		if( !m_primitives.empty() )
 		{
 			// construct the bounding volume hierarchy
-			m_BVHRoot = buildBVH( objs );
+			m_BVHRoot = buildBVH( 0, m_primitives.size() );
 			m_BVHRoot->calcNumNodesAndLeaves( &m_numNodes, &m_numLeaves );
 		}
-	}
-	else
-	{
-		// just use a vector of objects
-		m_objects = objs;
-	}
 
-	clock_t clockEnd = clock();
+		// the scratch memory is only needed during the build
+		m_scratchArena.release();
 
-	printf("\nTotal build time: %.4f seconds\n\n", ((float)(clockEnd - clockStart))/1000.0f);
+		MemoryStats::remove( MemoryStats::BVH_NODES, m_countedPrimitiveBytes );
+		m_countedPrimitiveBytes = primitiveBytes();
+		MemoryStats::add( MemoryStats::BVH_NODES, m_countedPrimitiveBytes );
+	}
+
+	printf("\nTotal build time: %.4f seconds\n\n", timer.elapsed());
 }
 
 void
 BVH::renderGL()
 {
+	// draws the volumes themselves (if VIEW_BOUNDING_VOLUMES is set), then their contents
 	if( m_BVHRoot )
 		m_BVHRoot->renderGL();
+
+	for( size_t i = 0; i < m_objects.size(); i++ )
+		m_objects[i]->renderGL();
+	for( size_t i = 0; i < m_meshes.size(); i++ )
+		m_meshes[i]->renderGL();
 }
 
 bool
@@ -63,24 +97,39 @@ BVH::intersect(HitInfo& minHit, const Ray& ray, float tMin, float tMax) const
 	{
 		// traverse the BVH to perform ray-intersection
 		if( m_BVHRoot )
-			return m_BVHRoot->intersect( minHit, ray, tMin, tMax );
+			return intersectNode( m_BVHRoot, minHit, ray, tMin, tMax );
 		else
 			return false;
 	}
 	else
 	{
-		// Just intersect every object.
+		// Just intersect every primitive, shrinking tMax as we find closer hits
 		bool hit = false;
 		HitInfo tempMinHit;
-		minHit.t = MIRO_TMAX;
+		PrimitiveRef prim;
 	    
-		for (size_t i = 0; i < m_objects->size(); ++i)
+		for (size_t i = 0; i < m_objects.size(); ++i)
 		{
-			if ((*m_objects)[i]->intersect(tempMinHit, ray, tMin, tMax))
+			if (m_objects[i]->intersect(tempMinHit, ray, tMin, tMax))
 			{
 				hit = true;
-				if (tempMinHit.t < minHit.t)
+				minHit = tempMinHit;
+				tMax = tempMinHit.t;
+			}
+		}
+
+		for (size_t i = 0; i < m_meshes.size(); ++i)
+		{
+			for (int j = 0; j < m_meshes[i]->numTris(); ++j)
+			{
+				prim.mesh = i;
+				prim.index = j;
+				if (intersectPrimitiveRef(prim, tempMinHit, ray, tMin, tMax))
+				{
+					hit = true;
 					minHit = tempMinHit;
+					tMax = tempMinHit.t;
+				}
 			}
 		}
 	    
@@ -88,6 +137,145 @@ BVH::intersect(HitInfo& minHit, const Ray& ray, float tMin, float tMax) const
 	}
 }
 
+bool
+BVH::intersectNode( const BoundingVolume * node, HitInfo& minHit, const Ray& ray, float tMin, float tMax ) const
+{
+	if( !node->intersect( ray, tMin, tMax ) )
+		return false;
+
+	// tMax shrinks to the closest hit so far, so anything found afterwards is closer
+	// and whole subtrees beyond it are culled by the volume test
+	bool intersectionFound = false;
+	HitInfo tempHit;
+
+	if( node->isLeaf() )
+	{
+		const unsigned int end = node->firstPrimitive() + node->numPrimitives();
+		for( unsigned int i = node->firstPrimitive(); i < end; i++ )
+		{
+			if( intersectPrimitiveRef( m_primitives[i], tempHit, ray, tMin, tMax ) )
+			{
+				minHit = tempHit;
+				tMax = tempHit.t;
+				intersectionFound = true;
+			}
+		}
+	}
+	else
+	{
+		for( int i = 0; i < node->numChildren(); i++ )
+		{
+			if( intersectNode( node->getChild( i ), tempHit, ray, tMin, tMax ) )
+			{
+				minHit = tempHit;
+				tMax = tempHit.t;
+				intersectionFound = true;
+			}
+		}
+	}
+
+	return intersectionFound;
+}
+
+bool
+BVH::intersectPrimitiveRef( const PrimitiveRef & prim, HitInfo& result, const Ray& ray, float tMin, float tMax ) const
+{
+	if( prim.mesh == PrimitiveRef::OBJECT )
+		return m_objects[prim.index]->intersect( result, ray, tMin, tMax );
+
+	TriangleMesh * mesh = m_meshes[prim.mesh];
+	if( !Triangle::intersect( result, ray, mesh, prim.index, tMin, tMax ) )
+		return false;
+
+	result.material = mesh->getMaterial( prim.index );
+	return true;
+}
+
+void
+BVH::getPrimitiveBounds( const PrimitiveRef & prim, Vector3 &min, Vector3 &max ) const
+{
+	if( prim.mesh == PrimitiveRef::OBJECT )
+		m_objects[prim.index]->getBounds( min, max );
+	else
+		Triangle::getBounds( m_meshes[prim.mesh], prim.index, min, max );
+}
+
+Vector3
+BVH::getPrimitiveMidPoint( const PrimitiveRef & prim ) const
+{
+	if( prim.mesh == PrimitiveRef::OBJECT )
+		return m_objects[prim.index]->getMidPoint();
+	else
+		return Triangle::getMidPoint( m_meshes[prim.mesh], prim.index );
+}
+
+void
+BVH::getBounds( Vector3 &min, Vector3 &max ) const
+{
+	if( m_BVHRoot )
+	{
+		m_BVHRoot->getBounds( min, max );
+	}
+	else
+	{
+		// no hierarchy was built (USE_BVH is off), so bound every primitive
+		Vector3 primMin, primMax;
+		bool minAndMaxSet = false;
+		PrimitiveRef prim;
+
+		prim.mesh = PrimitiveRef::OBJECT;
+		for( size_t i = 0; i < m_objects.size(); i++ )
+		{
+			prim.index = i;
+			getPrimitiveBounds( prim, primMin, primMax );
+			growBounds( min, max, primMin, primMax, minAndMaxSet );
+			minAndMaxSet = true;
+		}
+
+		for( size_t i = 0; i < m_meshes.size(); i++ )
+		{
+			prim.mesh = i;
+			for( int j = 0; j < m_meshes[i]->numTris(); j++ )
+			{
+				prim.index = j;
+				getPrimitiveBounds( prim, primMin, primMax );
+				growBounds( min, max, primMin, primMax, minAndMaxSet );
+				minAndMaxSet = true;
+			}
+		}
+	}
+}
+
+float
+BVH::sahCost() const
+{
+	if( !m_BVHRoot )
+		return 0.0f;
+
+	Vector3 min, max;
+	m_BVHRoot->getBounds( min, max );
+	const float rootSurfaceArea = BoundingBox::calcPotentialSurfaceArea( min, max );
+	return rootSurfaceArea > 0.0f ? nodeSAHCost( m_BVHRoot ) / rootSurfaceArea : 0.0f;
+}
+
+// the node's and its descendants' costs, each scaled by its (unnormalized) surface area
+float
+BVH::nodeSAHCost( const BoundingVolume * node )
+{
+	Vector3 min, max;
+	node->getBounds( min, max );
+	const float surfaceArea = BoundingBox::calcPotentialSurfaceArea( min, max );
+
+	// leaves are volumes too, and are tested before their primitives
+	float cost = surfaceArea * SAH_TRAVERSAL_COST;
+	if( node->isLeaf() )
+		return cost + surfaceArea * node->numPrimitives();
+
+	for( int i = 0; i < node->numChildren(); i++ )
+		cost += nodeSAHCost( node->getChild( i ) );
+	return cost;
+}
+
 float
 BVH::computeCost( float parentSurfaceArea, float childSurfaceArea, unsigned int childNumObjs )
 {
@@ -97,28 +285,35 @@ BVH::computeCost( float parentSurfaceArea, float childSurfaceArea, unsigned int
 }
 
 BoundingVolume *
-BVH::buildBVH( Objects * objs )
+BVH::buildBVH( unsigned int first, unsigned int count )
 {
-	if( objs->empty() )
+	if( count == 0 )
 		return NULL;
 
-	// keep track of the triangles' midpoints now so we don't have to iterate through them again
+	// keep track of the objects' midpoints now so we don't have to iterate through them again
 	static MidPointMap * midPointMap; // static to save stack space
 	Vector3 min, max; // can't be static; must be preserved through recursion
+	PrimitiveRef * prims = &m_primitives[first];
+
+	// everything this level puts in the scratch arena is freed before we recurse
+	MemoryArena::Marker scratchMarker = m_scratchArena.mark();
 
 	// base case: we've reached the desired number of primitives!
-	if( objs->size() <= NUM_LEAF_CHILDREN )
+	if( count <= NUM_LEAF_CHILDREN )
 	{
 		// we don't need the midpoints if we know this is a leaf node
-		midPointMap = getTriangleMinMaxAndMidpoints( objs, min, max, false );
+		midPointMap = getMinMaxAndMidpoints( prims, count, min, max, false );
 		// create a leaf node containing the primitives
-		return new BoundingBox( objs, true, min, max );
+		static BoundingVolume * leaf;
+		leaf = BoundingBox::create( m_nodeArena, true, min, max );
+		leaf->setPrimitives( first, count );
+		return leaf;
 	}	
 	// recursive case: we need to subdivide this bounding box
 	else
 	{
-		// we need to calculate the midpoints in this case; we'll free the memory later
-		midPointMap = getTriangleMinMaxAndMidpoints( objs, min, max, true );
+		// we need to calculate the midpoints in this case; they're in the scratch arena
+		midPointMap = getMinMaxAndMidpoints( prims, count, min, max, true );
 
 		static float thisBVSurfaceArea;
 		thisBVSurfaceArea = BoundingBox::calcPotentialSurfaceArea( min, max );
@@ -126,16 +321,16 @@ BVH::buildBVH( Objects * objs )
 		static SplitStats bestXSplit, bestYSplit, bestZSplit;
 
 		// find best splitting option along the x axis
-		qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByXComponent );
-		bestXSplit = findBestSplit( objs, midPointMap, objs->size(), thisBVSurfaceArea );
+		qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByXComponent );
+		bestXSplit = findBestSplit( prims, midPointMap, count, thisBVSurfaceArea );
 
 		// find best splitting option along the y axis
-		qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByYComponent );
-		bestYSplit = findBestSplit( objs, midPointMap, objs->size(), thisBVSurfaceArea );
+		qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByYComponent );
+		bestYSplit = findBestSplit( prims, midPointMap, count, thisBVSurfaceArea );
 
 		// find best splitting option along the z axis
-		qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByZComponent );
-		bestZSplit = findBestSplit( objs, midPointMap, objs->size(), thisBVSurfaceArea );
+		qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByZComponent );
+		bestZSplit = findBestSplit( prims, midPointMap, count, thisBVSurfaceArea );
 	
 		static float bestXTotalCost, bestYTotalCost, bestZTotalCost;
 		static unsigned int bestSplitLastLeftNodeIdx;
@@ -147,112 +342,77 @@ BVH::buildBVH( Objects * objs )
 		if( bestXTotalCost <= bestYTotalCost && bestXTotalCost <= bestZTotalCost )
 		{
 			// use x split; put objects back in x component order
-			qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByXComponent );
+			qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByXComponent );
 			bestSplitLastLeftNodeIdx = bestXSplit.lastLeftNodeIndex;
 		}
 		else if( bestYTotalCost <= bestXTotalCost && bestYTotalCost <= bestZTotalCost )
 		{
 			// use y split; put objects back in y component order
-			qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByYComponent );
+			qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByYComponent );
 			bestSplitLastLeftNodeIdx = bestYSplit.lastLeftNodeIndex;
 		}
 		else
 		{
 			// use z split; put objects back in z component order
-			qsort( midPointMap, objs->size(), sizeof( MidPointMap ), BVH::sortByZComponent );
+			qsort( midPointMap, count, sizeof( MidPointMap ), BVH::sortByZComponent );
 			bestSplitLastLeftNodeIdx = bestZSplit.lastLeftNodeIndex;
 		}
 
-		Objects * leftChildObjs = new Objects();
-		Objects * rightChildObjs = new Objects();
+		// reorder our range of the primitive array into the chosen order, so the left
+		// child gets the front of the range and the right child gets the rest
+		static PrimitiveRef * sortedPrims;
 		static unsigned int i; // static iterator to save stack space
-		// create the child object vectors
-		for( i = 0; i < objs->size(); i++ )
-		{
-			// put this triangle in the left child
-			if( i <= bestSplitLastLeftNodeIdx )
-				leftChildObjs->push_back( (*objs)[midPointMap[i].origIndex] );
-			// put this triangle in the right child
-			else 
-				rightChildObjs->push_back( (*objs)[midPointMap[i].origIndex] );
-		}
+		sortedPrims = m_scratchArena.alloc<PrimitiveRef>( count );
+		for( i = 0; i < count; i++ )
+			sortedPrims[i] = prims[midPointMap[i].origIndex];
+		for( i = 0; i < count; i++ )
+			prims[i] = sortedPrims[i];
 
-		// we're done with our midpointMap; free the midPointMap memory
-		delete [] midPointMap;
+		unsigned int numLeft = bestSplitLastLeftNodeIdx + 1;
+
+		// we're done with this level's midpointMap and sorted copy
 		midPointMap = NULL;
+		m_scratchArena.rewind( scratchMarker );
+
+		// allocate this node before its children so that nodes are laid out depth-first
+		BoundingVolume * bv = BoundingBox::create( m_nodeArena, false, min, max );
+
+		// now recursively build the hierarchy for each node; only add non-null children
+		BoundingVolume * leftBV = buildBVH( first, numLeft );
+		if( leftBV )
+			bv->addChild( leftBV );
 
-		// now recursively build the hierarchy for each node
-		Objects * childObjs = new Objects();
-
-		// build the left child
-		BoundingVolume * leftBV = buildBVH( leftChildObjs );
-		// now we're done with our local leftChildObjs; delete it
-        delete leftChildObjs;
-        leftChildObjs = NULL;
-        if( leftBV ) // only add it to this bounding volume if it's non-null
-                childObjs->push_back( leftBV );
-
-		// build the right child
-		BoundingVolume * rightBV = buildBVH( rightChildObjs );
-		// now we're done with our local rightChildObjs; delete it
-        delete rightChildObjs;
-        rightChildObjs = NULL;
-        if( rightBV ) // only add it to this bounding volume if it's non-null
-                childObjs->push_back( rightBV );
-
-		// finally, construct this bounding volume and return it
-        static BoundingVolume * bv;
-        bv = new BoundingBox( childObjs, false, min, max );             
-        // now we're done with childObjs; delete it
-        delete childObjs;
-        childObjs = NULL;
-
-        return bv;
+		BoundingVolume * rightBV = buildBVH( first + numLeft, count - numLeft );
+		if( rightBV )
+			bv->addChild( rightBV );
+
+		return bv;
 	}
 }
 
 BVH::SplitStats
-BVH::findBestSplit( Objects * objs, BVH::MidPointMap * sortedMidPointMap, int numMidPoints, float parentSurfaceArea )
+BVH::findBestSplit( const PrimitiveRef * prims, BVH::MidPointMap * sortedMidPointMap, int numMidPoints, float parentSurfaceArea )
 {
 	// make these variables static to save stack space
 	static SplitStats * allSplitStats;
 	static SplitStats bestSplit; 
-	static int i, j, numTris;
+	static MemoryArena::Marker scratchMarker;
+	static int i, numTris;
 	static Vector3 min, max;
-	static Triangle * tri; 		
-	static Vector3 triVerts[3]; 
-	static TriangleMesh::TupleI3 ti3; 
+	static Vector3 objMin, objMax;
 	static bool minAndMaxSet;
 		
 	// we're going to have numMidPoints - 1 possibilities for a split
-	allSplitStats = new SplitStats[numMidPoints - 1];
+	scratchMarker = m_scratchArena.mark();
+	allSplitStats = m_scratchArena.alloc<SplitStats>( numMidPoints - 1 );
 
 	minAndMaxSet = false;
 	// determine the cost of the left child for each split
 	for( i = 0, numTris = 1; i < (numMidPoints - 1); i++, numTris++ )
 	{
-		tri = ( Triangle * )(*objs)[sortedMidPointMap[i].origIndex];
-		ti3 = tri->getMesh()->vIndices()[tri->getIndex()];
-		triVerts[0] = tri->getMesh()->vertices()[ti3.x]; //vertex a of triangle
-		triVerts[1] = tri->getMesh()->vertices()[ti3.y]; //vertex b of triangle
-		triVerts[2] = tri->getMesh()->vertices()[ti3.z]; //vertex c of triangle
-		for( j = 0; j < 3; j++ )
-		{
-			if( !minAndMaxSet || triVerts[j].x < min.x )
-				min.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y < min.y )
-				min.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z < min.z )
-				min.z = triVerts[j].z;
-			if( !minAndMaxSet || triVerts[j].x > max.x )
-				max.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y > max.y )
-				max.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z > max.z )
-				max.z = triVerts[j].z;
-
-			minAndMaxSet = true;
-		}
+		getPrimitiveBounds( prims[sortedMidPointMap[i].origIndex], objMin, objMax );
+		growBounds( min, max, objMin, objMax, minAndMaxSet );
+		minAndMaxSet = true;
 
 		allSplitStats[i].lastLeftNodeIndex = i;
 		allSplitStats[i].leftBVCost = computeCost( parentSurfaceArea, BoundingBox::calcPotentialSurfaceArea( min, max ), numTris );
@@ -262,28 +422,9 @@ BVH::findBestSplit( Objects * objs, BVH::MidPointMap * sortedMidPointMap, int nu
 	// determine the cost of the right child for each split
 	for( i = ( numMidPoints - 1 ), numTris = 1; i > 0; i--,numTris++ )
 	{
-		tri = ( Triangle * )(*objs)[sortedMidPointMap[i].origIndex];
-		ti3 = tri->getMesh()->vIndices()[tri->getIndex()];
-		triVerts[0] = tri->getMesh()->vertices()[ti3.x]; //vertex a of triangle
-		triVerts[1] = tri->getMesh()->vertices()[ti3.y]; //vertex b of triangle
-		triVerts[2] = tri->getMesh()->vertices()[ti3.z]; //vertex c of triangle
-		for( j = 0; j < 3; j++ )
-		{
-			if( !minAndMaxSet || triVerts[j].x < min.x )
-				min.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y < min.y )
-				min.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z < min.z )
-				min.z = triVerts[j].z;
-			if( !minAndMaxSet || triVerts[j].x > max.x )
-				max.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y > max.y )
-				max.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z > max.z )
-				max.z = triVerts[j].z;
-
-			minAndMaxSet = true;
-		}
+		getPrimitiveBounds( prims[sortedMidPointMap[i].origIndex], objMin, objMax );
+		growBounds( min, max, objMin, objMax, minAndMaxSet );
+		minAndMaxSet = true;
 
 		allSplitStats[i-1].rightBVCost = computeCost( parentSurfaceArea, BoundingBox::calcPotentialSurfaceArea( min, max ), numTris );
 	}
@@ -303,7 +444,7 @@ BVH::findBestSplit( Objects * objs, BVH::MidPointMap * sortedMidPointMap, int nu
 	}
 
 	// free the split stats memory
-	delete [] allSplitStats;
+	m_scratchArena.rewind( scratchMarker );
 	allSplitStats = NULL;
 
 	// return the best choice
@@ -311,48 +452,28 @@ BVH::findBestSplit( Objects * objs, BVH::MidPointMap * sortedMidPointMap, int nu
 }
 
 BVH::MidPointMap *
-BVH::getTriangleMinMaxAndMidpoints( Objects *objs, Vector3 &min, Vector3 &max, bool setMidPoints )
+BVH::getMinMaxAndMidpoints( const PrimitiveRef * prims, unsigned int count, Vector3 &min, Vector3 &max, bool setMidPoints )
 {
-	MidPointMap * midPointMap = setMidPoints ? new MidPointMap[objs->size()] : NULL;
+	// the caller frees the midpoints by rewinding the scratch arena
+	MidPointMap * midPointMap = setMidPoints ? m_scratchArena.alloc<MidPointMap>( count ) : NULL;
 
 	// make variable static to save stack space
 	static bool minAndMaxSet;
 	minAndMaxSet = false;
 
-	static size_t i, j; // static to save stack space
-	for( i = 0; i < objs->size(); i++ )
+	static unsigned int i; // static to save stack space
+	for( i = 0; i < count; i++ )
 	{
-		static Triangle * tri; // static to save stack space		
-		static Vector3 triVerts[3]; // static to save stack space
-		static TriangleMesh::TupleI3 ti3; // static to save stack space
-
-		tri = ( Triangle * )(*objs)[i];
-		ti3 = tri->getMesh()->vIndices()[tri->getIndex()];
-		triVerts[0] = tri->getMesh()->vertices()[ti3.x]; //vertex a of triangle
-		triVerts[1] = tri->getMesh()->vertices()[ti3.y]; //vertex b of triangle
-		triVerts[2] = tri->getMesh()->vertices()[ti3.z]; //vertex c of triangle
-		for( j = 0; j < 3; j++ )
-		{
-			if( !minAndMaxSet || triVerts[j].x < min.x )
-				min.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y < min.y )
-				min.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z < min.z )
-				min.z = triVerts[j].z;
-			if( !minAndMaxSet || triVerts[j].x > max.x )
-				max.x = triVerts[j].x;
-			if( !minAndMaxSet || triVerts[j].y > max.y )
-				max.y = triVerts[j].y;
-			if( !minAndMaxSet || triVerts[j].z > max.z )
-				max.z = triVerts[j].z;
+		static Vector3 objMin, objMax; // static to save stack space
 
-			minAndMaxSet = true;
-		}
+		getPrimitiveBounds( prims[i], objMin, objMax );
+		growBounds( min, max, objMin, objMax, minAndMaxSet );
+		minAndMaxSet = true;
 
-		// add this triangle's midpoint to the midpoint vector
+		// add this object's midpoint to the midpoint vector
 		if( setMidPoints )
 		{
-			midPointMap[i].midPoint = tri->getMidPoint();
+			midPointMap[i].midPoint = getPrimitiveMidPoint( prims[i] );
 			midPointMap[i].origIndex = i;
 		}
 	}
@@ -360,6 +481,23 @@ BVH::getTriangleMinMaxAndMidpoints( Objects *objs, Vector3 &min, Vector3 &max, b
 	return midPointMap;
 }
 
+void
+BVH::growBounds( Vector3 &min, Vector3 &max, const Vector3 &objMin, const Vector3 &objMax, bool minAndMaxSet )
+{
+	if( !minAndMaxSet || objMin.x < min.x )
+		min.x = objMin.x;
+	if( !minAndMaxSet || objMin.y < min.y )
+		min.y = objMin.y;
+	if( !minAndMaxSet || objMin.z < min.z )
+		min.z = objMin.z;
+	if( !minAndMaxSet || objMax.x > max.x )
+		max.x = objMax.x;
+	if( !minAndMaxSet || objMax.y > max.y )
+		max.y = objMax.y;
+	if( !minAndMaxSet || objMax.z > max.z )
+		max.z = objMax.z;
+}
+
 int
 BVH::sortByXComponent( const void * p1, const void * p2 )
 {
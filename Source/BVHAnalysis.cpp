@@ -0,0 +1,146 @@
+#include "BVHAnalysis.h"
+#include "BoundingBox.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <stdio.h>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+BVHAnalysis::BVHAnalysis( const BVH & bvh ) :
+	sahCost( bvh.sahCost() ), numNodes( 0 ), numLeaves( 0 ), overlapRatio( 0.0 ),
+	nodeBytes( bvh.nodeBytes() ), primitiveBytes( bvh.primitiveBytes() ), m_bvh( bvh )
+{
+	double overlapArea = 0.0, innerArea = 0.0;
+	if( bvh.root() )
+		addNode( bvh.root(), 0, overlapArea, innerArea );
+	if( innerArea > 0.0 )
+		overlapRatio = overlapArea / innerArea;
+}
+
+void
+BVHAnalysis::addNode( const BoundingVolume * node, int depth, double & overlapArea, double & innerArea )
+{
+	numNodes++;
+
+	if( node->isLeaf() )
+	{
+		numLeaves++;
+		if( (int)leavesAtDepth.size() <= depth )
+			leavesAtDepth.resize( depth + 1, 0 );
+		leavesAtDepth[depth]++;
+		if( leavesWithSize.size() <= node->numPrimitives() )
+			leavesWithSize.resize( node->numPrimitives() + 1, 0 );
+		leavesWithSize[node->numPrimitives()]++;
+		return;
+	}
+
+	Vector3 min, max;
+	node->getBounds( min, max );
+	innerArea += BoundingBox::calcPotentialSurfaceArea( min, max );
+
+	if( node->numChildren() == 2 )
+	{
+		Vector3 min0, max0, min1, max1;
+		node->getChild( 0 )->getBounds( min0, max0 );
+		node->getChild( 1 )->getBounds( min1, max1 );
+
+		const Vector3 overlapMin( std::max( min0.x, min1.x ), std::max( min0.y, min1.y ), std::max( min0.z, min1.z ) );
+		const Vector3 overlapMax( std::min( max0.x, max1.x ), std::min( max0.y, max1.y ), std::min( max0.z, max1.z ) );
+		if( overlapMin.x <= overlapMax.x && overlapMin.y <= overlapMax.y && overlapMin.z <= overlapMax.z )
+			overlapArea += BoundingBox::calcPotentialSurfaceArea( overlapMin, overlapMax );
+	}
+
+	for( int i = 0; i < node->numChildren(); i++ )
+		addNode( node->getChild( i ), depth + 1, overlapArea, innerArea );
+}
+
+void
+BVHAnalysis::print() const
+{
+	printf( "BVH analysis:\n" );
+	printf( "\t%d nodes, %d leaves (up to %d primitive(s) per leaf)\n", numNodes, numLeaves, NUM_LEAF_CHILDREN );
+	printf( "\tSAH cost: %.3f (a node test costs %.2f primitive tests)\n", sahCost, SAH_TRAVERSAL_COST );
+	printf( "\tChild overlap: %.2f%% of the inner nodes' surface area\n", overlapRatio * 100.0 );
+	printf( "\tMemory: %.2f MB of nodes, %.2f MB of primitive references\n",
+		nodeBytes / ( 1024.0 * 1024.0 ), primitiveBytes / ( 1024.0 * 1024.0 ) );
+
+	printf( "\tLeaves by depth:\n" );
+	for( size_t i = 0; i < leavesAtDepth.size(); i++ )
+	{
+		if( leavesAtDepth[i] > 0 )
+			printf( "\t\t%3d: %d\n", (int)i, leavesAtDepth[i] );
+	}
+
+	printf( "\tLeaves by number of primitives:\n" );
+	for( size_t i = 0; i < leavesWithSize.size(); i++ )
+	{
+		if( leavesWithSize[i] > 0 )
+			printf( "\t\t%3d: %d\n", (int)i, leavesWithSize[i] );
+	}
+}
+
+bool
+BVHAnalysis::exportOBJ( const char * filename, int maxDepth ) const
+{
+	FILE * fp = fopen( filename, "w" );
+	if( !fp )
+	{
+		fprintf( stderr, "Couldn't open %s for writing\n", filename );
+		return false;
+	}
+
+	fprintf( fp, "# BVH with %d nodes; each node's box is 12 lines, grouped by depth\n", numNodes );
+
+	// a level at a time, so each depth's boxes are in one group
+	std::vector<const BoundingVolume *> nodes;
+	if( m_bvh.root() )
+		nodes.push_back( m_bvh.root() );
+
+	// corners are numbered by which of x, y and z (bits 0, 1 and 2) are at the max
+	static const int edges[12][2] =
+	{
+		{0,1}, {2,3}, {4,5}, {6,7},     // along x
+		{0,2}, {1,3}, {4,6}, {5,7},     // along y
+		{0,4}, {1,5}, {2,6}, {3,7}      // along z
+	};
+	int numVertices = 0;
+	for( int depth = 0; !nodes.empty() && ( maxDepth < 0 || depth <= maxDepth ); depth++ )
+	{
+		fprintf( fp, "g depth_%d\n", depth );
+
+		std::vector<const BoundingVolume *> children;
+		for( size_t i = 0; i < nodes.size(); i++ )
+		{
+			Vector3 min, max;
+			nodes[i]->getBounds( min, max );
+			for( int corner = 0; corner < 8; corner++ )
+			{
+				fprintf( fp, "v %g %g %g\n", corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y,
+					corner & 4 ? max.z : min.z );
+			}
+			for( int e = 0; e < 12; e++ )
+				fprintf( fp, "l %d %d\n", numVertices + edges[e][0] + 1, numVertices + edges[e][1] + 1 );
+			numVertices += 8;
+
+			for( int c = 0; c < nodes[i]->numChildren(); c++ )
+				children.push_back( nodes[i]->getChild( c ) );
+		}
+		nodes.swap( children );
+	}
+
+	const bool ok = !ferror( fp );
+	fclose( fp );
+	return ok;
+}
+
+double
+BVHAnalysis::measuredCost( const RenderStats::Counters & counters )
+{
+	const RenderStats::Count numRays = counters.totalRays();
+	if( numRays == 0 )
+		return 0.0;
+	return ( counters.boundingVolumeTests * SAH_TRAVERSAL_COST + counters.primitiveTests ) / (double)numRays;
+}
@@ -0,0 +1,284 @@
+#include "Benchmark.h"
+#include "BenchmarkUtil.h"
+#include "BVH.h"
+#include "TriangleMesh.h"
+#include "Ray.h"
+#include "Random.h"
+#include "RenderStats.h"
+#include "Timer.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <stdio.h>
+
+namespace
+{
+
+// slashes work on Windows too
+const char * MESH_FILES[] =
+{
+	"Resource/bunny.obj",
+	"Resource/teapot.obj",
+	"Resource/sphere_high_res.obj",
+	"Resource/cattails.obj",
+	"Resource/water_weeds.obj"
+};
+const int NUM_MESHES = sizeof(MESH_FILES) / sizeof(MESH_FILES[0]);
+
+enum RaySet
+{
+	PRIMARY_RAYS,
+	RANDOM_RAYS,
+	SHADOW_RAYS,
+	NUM_RAY_SETS
+};
+
+const char * RAY_SET_NAMES[NUM_RAY_SETS] = {"primary", "random", "shadow"};
+
+// a ray and how far along it to look
+struct BenchmarkRay
+{
+	Ray ray;
+	float tMin;
+	float tMax;
+};
+
+struct Result
+{
+	std::string mesh;
+	int numTriangles;
+	int numNodes;
+	int numLeaves;
+	double buildSeconds;
+	float sahCost;
+	const char * raySet;
+	int numRays;
+	int numHits;
+	BenchmarkTiming timing; // the fastest of the runs
+	double nodeTestsPerRay;
+	double primitiveTestsPerRay;
+};
+
+// traces every ray BENCHMARK_NUM_RUNS times, filling in the timing, hits and tests per ray
+void
+traceRays( const BVH & bvh, const std::vector<BenchmarkRay>& rays, Result & result, std::vector<HitInfo> * hits = 0 )
+{
+	result.numRays = (int)rays.size();
+	result.numHits = 0;
+	result.timing.clear();
+	result.nodeTestsPerRay = result.primitiveTestsPerRay = 0.0;
+	if( rays.empty() )
+		return;
+	if( hits )
+		hits->assign( rays.size(), HitInfo( -1.0f ) );
+
+	for( int run = 0; run < BENCHMARK_NUM_RUNS; run++ )
+	{
+		const RenderStats::Counters before = RenderStats::local();
+		int numHits = 0;
+		result.timing.start();
+
+		HitInfo hit;
+		for( size_t i = 0; i < rays.size(); i++ )
+		{
+			if( bvh.intersect( hit, rays[i].ray, rays[i].tMin, rays[i].tMax ) )
+			{
+				numHits++;
+				if( hits )
+					(*hits)[i] = hit;
+			}
+		}
+
+		result.timing.stop();
+
+		// every run does the same tests
+		const RenderStats::Counters& after = RenderStats::local();
+		result.numHits = numHits;
+		result.nodeTestsPerRay = (double)( after.boundingVolumeTests - before.boundingVolumeTests ) / rays.size();
+		result.primitiveTestsPerRay = (double)( after.primitiveTests - before.primitiveTests ) / rays.size();
+	}
+}
+
+// returns false if the mesh couldn't be loaded
+bool
+benchmarkMesh( const char * filename, std::vector<Result>& results )
+{
+	TriangleMesh mesh;
+	if( !BenchmarkUtil::loadMesh( mesh, filename ) )
+	{
+		fprintf( stderr, "Couldn't load %s; skipping it\n", filename );
+		return false;
+	}
+
+	TriangleMeshes meshes;
+	meshes.push_back( &mesh );
+
+	BVH bvh;
+	Timer buildTimer;
+	bvh.build( 0, &meshes );
+	const double buildSeconds = buildTimer.elapsed();
+
+	Vector3 min, max;
+	bvh.getBounds( min, max );
+	const Vector3 center = ( min + max ) * 0.5f;
+	const float radius = std::max( ( max - min ).length() * 0.5f, 1e-6f );
+	const float epsilon = radius * 1e-4f;
+
+	Result base;
+	base.mesh = filename;
+	base.numTriangles = mesh.numTris();
+	base.numNodes = bvh.numNodes();
+	base.numLeaves = bvh.numLeaves();
+	base.buildSeconds = buildSeconds;
+	base.sahCost = bvh.sahCost();
+
+	Random random( BENCHMARK_SEED );
+	std::vector<BenchmarkRay> rays;
+	BenchmarkRay r;
+
+	// primary: a square image that just fits the bounding sphere, looking down -z from outside it
+	const Vector3 eye = center + Vector3( 0.0f, 0.0f, 3.0f * radius );
+	const float halfWidth = 0.36f; // just over tan(asin(1/3)), the sphere's angular radius from there
+	for( int j = 0; j < BENCHMARK_IMAGE_SIZE; j++ )
+	{
+		for( int i = 0; i < BENCHMARK_IMAGE_SIZE; i++ )
+		{
+			const float u = ( ( i + 0.5f ) / BENCHMARK_IMAGE_SIZE * 2.0f - 1.0f ) * halfWidth;
+			const float v = ( ( j + 0.5f ) / BENCHMARK_IMAGE_SIZE * 2.0f - 1.0f ) * halfWidth;
+			Vector3 d( u, v, -1.0f );
+			d.normalize();
+			r.ray = Ray( eye, d );
+			r.tMin = 0.0f;
+			r.tMax = MIRO_TMAX;
+			rays.push_back( r );
+		}
+	}
+	Result primary = base;
+	primary.raySet = RAY_SET_NAMES[PRIMARY_RAYS];
+	std::vector<HitInfo> hits;
+	traceRays( bvh, rays, primary, &hits );
+	results.push_back( primary );
+
+	// shadow: from every primary hit to a light above and to the side of the mesh
+	const Vector3 light = center + Vector3( radius, 3.0f * radius, 2.0f * radius );
+	std::vector<BenchmarkRay> shadowRays;
+	for( size_t i = 0; i < rays.size(); i++ )
+	{
+		if( hits[i].t < 0.0f )
+			continue;
+		const Vector3 p = rays[i].ray.o + rays[i].ray.d * hits[i].t;
+		Vector3 toLight = light - p;
+		const float distance = toLight.length();
+		toLight /= distance;
+		r.ray = Ray( p, toLight );
+		r.tMin = epsilon;
+		r.tMax = distance;
+		shadowRays.push_back( r );
+	}
+
+	// random: anywhere in the bounds, in any direction
+	rays.clear();
+	for( int i = 0; i < BENCHMARK_NUM_RANDOM_RAYS; i++ )
+	{
+		const Vector3 o( min.x + ( max.x - min.x ) * random.nextFloat(),
+						 min.y + ( max.y - min.y ) * random.nextFloat(),
+						 min.z + ( max.z - min.z ) * random.nextFloat() );
+		r.ray = Ray( o, BenchmarkUtil::randomDirection( random ) );
+		r.tMin = 0.0f;
+		r.tMax = MIRO_TMAX;
+		rays.push_back( r );
+	}
+	Result incoherent = base;
+	incoherent.raySet = RAY_SET_NAMES[RANDOM_RAYS];
+	traceRays( bvh, rays, incoherent );
+	results.push_back( incoherent );
+
+	Result shadow = base;
+	shadow.raySet = RAY_SET_NAMES[SHADOW_RAYS];
+	traceRays( bvh, shadowRays, shadow );
+	results.push_back( shadow );
+	return true;
+}
+
+double
+megaRaysPerSecond( const Result & result )
+{
+	return result.timing.seconds() > 0.0 ? result.numRays / result.timing.seconds() * 1e-6 : 0.0;
+}
+
+// what the ray set really cost, in the SAH cost's units (see BVHAnalysis::measuredCost())
+double
+costPerRay( const Result & result )
+{
+	return result.nodeTestsPerRay * SAH_TRAVERSAL_COST + result.primitiveTestsPerRay;
+}
+
+void
+writeResult( BenchmarkWriter & writer, const Result & r )
+{
+	writer.addString( "mesh", r.mesh.c_str() );
+	writer.addInt( "triangles", r.numTriangles );
+	writer.addInt( "nodes", r.numNodes );
+	writer.addInt( "leaves", r.numLeaves );
+	writer.addDouble( "build_seconds", r.buildSeconds, 6 );
+	writer.addDouble( "sah_cost", r.sahCost, 4 );
+	writer.addString( "rays", r.raySet );
+	writer.addInt( "num_rays", r.numRays );
+	writer.addInt( "hits", r.numHits );
+	writer.addDouble( "seconds", r.timing.seconds(), 6 );
+	writer.addDouble( "mrays_per_second", megaRaysPerSecond( r ), 4 );
+	writer.addDouble( "node_tests_per_ray", r.nodeTestsPerRay, 4 );
+	writer.addDouble( "primitive_tests_per_ray", r.primitiveTestsPerRay, 4 );
+	writer.addDouble( "cost_per_ray", costPerRay( r ), 4 );
+	writer.addCounters( r.timing, r.numRays, "ray" );
+	writer.endRow();
+}
+
+} // namespace
+
+
+bool
+Benchmark::run( const char * filename )
+{
+	if( !USE_RENDER_STATS )
+		printf( "Ray statistics are compiled out (USE_RENDER_STATS), so there are no tests per ray\n" );
+
+	std::vector<Result> results;
+	int numMissing = 0;
+	for( int i = 0; i < NUM_MESHES; i++ )
+	{
+		if( !benchmarkMesh( MESH_FILES[i], results ) )
+			numMissing++;
+	}
+
+	printf( "\n%-30s %8s %8s %10s %8s %9s %10s %12s\n", "mesh", "build s", "SAH", "rays", "Mrays/s",
+		"nodes/ray", "prims/ray", "hits" );
+	for( size_t i = 0; i < results.size(); i++ )
+	{
+		const Result & r = results[i];
+		printf( "%-30s %8.3f %8.2f %10s %8.3f %9.2f %10.2f %5d/%-6d\n", r.mesh.c_str(), r.buildSeconds, r.sahCost,
+			r.raySet, megaRaysPerSecond( r ), r.nodeTestsPerRay, r.primitiveTestsPerRay, r.numHits, r.numRays );
+		if( r.timing.haveCounters() )
+		{
+			printf( "%-30s %8s %8s %10s %.2f IPC, %.2f cache misses/ray, %.2f branch misses/ray\n", "", "", "", "",
+				r.timing.counters().ipc(), r.timing.perUnit( PerfCounters::CACHE_MISSES, r.numRays ),
+				r.timing.perUnit( PerfCounters::BRANCH_MISSES, r.numRays ) );
+		}
+	}
+
+	BenchmarkWriter writer;
+	if( !writer.open( filename ) )
+		return false;
+	writer.addProperty( "leaf_size", NUM_LEAF_CHILDREN );
+	for( size_t i = 0; i < results.size(); i++ )
+		writeResult( writer, results[i] );
+	const bool ok = writer.close();
+
+	if( ok )
+		printf( "\nWrote the results to %s\n", filename );
+	// results missing a mesh can't be compared with earlier ones
+	if( numMissing > 0 )
+		fprintf( stderr, "\nFAILED: %d of the %d meshes couldn't be loaded (run from the directory with Resource in it)\n", numMissing, NUM_MESHES );
+	return ok && numMissing == 0;
+}
@@ -0,0 +1,254 @@
+#include "BenchmarkUtil.h"
+#include "Miro.h"
+#include "Random.h"
+#include "Timer.h"
+#include "TriangleMesh.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+void
+BenchmarkTiming::clear()
+{
+	m_num_runs = 0;
+	m_seconds = 0.0;
+	m_have_counters = false;
+	m_counters.clear();
+	m_start = 0.0;
+	m_counting = false;
+}
+
+void
+BenchmarkTiming::start()
+{
+	m_counting = PerfCounters::read( m_before );
+	m_start = Timer::now();
+}
+
+void
+BenchmarkTiming::stop()
+{
+	const double seconds = Timer::now() - m_start;
+	PerfCounters::Sample after;
+	const bool counted = m_counting && PerfCounters::read( after );
+
+	if( m_num_runs == 0 || seconds < m_seconds )
+	{
+		m_seconds = seconds;
+		m_have_counters = counted;
+		m_counters.clear();
+		if( counted )
+			m_counters.addDifference( m_before, after );
+	}
+	m_num_runs++;
+}
+
+double
+BenchmarkTiming::perUnit( PerfCounters::Counter counter, int count ) const
+{
+	return count > 0 ? (double)m_counters.values[counter] / count : 0.0;
+}
+
+
+BenchmarkWriter::BenchmarkWriter() :
+	m_fp(0),
+	m_csv(false),
+	m_num_rows(0),
+	m_began_results(false)
+{
+}
+
+BenchmarkWriter::~BenchmarkWriter()
+{
+	if( m_fp )
+		close();
+}
+
+bool
+BenchmarkWriter::open( const char * filename )
+{
+	m_fp = fopen( filename, "w" );
+	if( !m_fp )
+	{
+		fprintf( stderr, "Couldn't open benchmark file %s for writing\n", filename );
+		return false;
+	}
+	m_csv = BenchmarkUtil::isCSV( filename );
+	m_num_rows = 0;
+	m_began_results = false;
+	if( !m_csv )
+		fprintf( m_fp, "{\n" );
+	return true;
+}
+
+void
+BenchmarkWriter::addProperty( const char * name, int value )
+{
+	if( !m_csv )
+		fprintf( m_fp, "  \"%s\": %d,\n", name, value );
+}
+
+void
+BenchmarkWriter::addString( const char * column, const char * value )
+{
+	if( m_csv )
+	{
+		add( column, value, true );
+		return;
+	}
+
+	// Windows file names have backslashes
+	std::string quoted = "\"";
+	for( const char * c = value; *c; c++ )
+	{
+		if( *c == '\\' || *c == '"' )
+			quoted += '\\';
+		quoted += *c;
+	}
+	quoted += '"';
+	add( column, quoted, true );
+}
+
+void
+BenchmarkWriter::addInt( const char * column, int value )
+{
+	char text[32];
+	sprintf( text, "%d", value );
+	add( column, text, true );
+}
+
+void
+BenchmarkWriter::addDouble( const char * column, double value, int decimals )
+{
+	char text[64];
+	sprintf( text, "%.*f", decimals, value );
+	add( column, text, true );
+}
+
+void
+BenchmarkWriter::addMissing( const char * column )
+{
+	add( column, "", false );
+}
+
+void
+BenchmarkWriter::addCounters( const BenchmarkTiming & timing, int count, const char * unit )
+{
+	const std::string cacheMisses = std::string( "cache_misses_per_" ) + unit;
+	const std::string branchMisses = std::string( "branch_misses_per_" ) + unit;
+	if( timing.haveCounters() )
+	{
+		addDouble( "ipc", timing.counters().ipc(), 4 );
+		addDouble( cacheMisses.c_str(), timing.perUnit( PerfCounters::CACHE_MISSES, count ), 4 );
+		addDouble( branchMisses.c_str(), timing.perUnit( PerfCounters::BRANCH_MISSES, count ), 4 );
+	}
+	else
+	{
+		addMissing( "ipc" );
+		addMissing( cacheMisses.c_str() );
+		addMissing( branchMisses.c_str() );
+	}
+}
+
+void
+BenchmarkWriter::add( const char * column, const std::string & value, bool present )
+{
+	m_columns.push_back( column );
+	m_values.push_back( value );
+	m_present.push_back( present );
+}
+
+void
+BenchmarkWriter::beginResults()
+{
+	if( !m_csv && !m_began_results )
+		fprintf( m_fp, "  \"results\": [\n" );
+	m_began_results = true;
+}
+
+void
+BenchmarkWriter::endRow()
+{
+	beginResults();
+
+	if( m_csv )
+	{
+		if( m_num_rows == 0 )
+		{
+			for( size_t i = 0; i < m_columns.size(); i++ )
+				fprintf( m_fp, "%s%s", i > 0 ? "," : "", m_columns[i].c_str() );
+			fprintf( m_fp, "\n" );
+		}
+		for( size_t i = 0; i < m_values.size(); i++ )
+			fprintf( m_fp, "%s%s", i > 0 ? "," : "", m_values[i].c_str() );
+		fprintf( m_fp, "\n" );
+	}
+	else
+	{
+		fprintf( m_fp, "%s    {", m_num_rows > 0 ? ",\n" : "" );
+		bool first = true;
+		for( size_t i = 0; i < m_values.size(); i++ )
+		{
+			if( !m_present[i] )
+				continue;
+			fprintf( m_fp, "%s\"%s\": %s", first ? "" : ", ", m_columns[i].c_str(), m_values[i].c_str() );
+			first = false;
+		}
+		fprintf( m_fp, "}" );
+	}
+
+	m_num_rows++;
+	m_columns.clear();
+	m_values.clear();
+	m_present.clear();
+}
+
+bool
+BenchmarkWriter::close()
+{
+	if( !m_fp )
+		return false;
+
+	if( !m_csv )
+	{
+		beginResults();
+		fprintf( m_fp, "%s  ]\n}\n", m_num_rows > 0 ? "\n" : "" );
+	}
+
+	const bool ok = !ferror( m_fp );
+	fclose( m_fp );
+	m_fp = 0;
+	return ok;
+}
+
+
+Vector3
+BenchmarkUtil::randomDirection( Random & random )
+{
+	const float z = 1.0f - 2.0f * random.nextFloat();
+	const float r = sqrtf( std::max( 0.0f, 1.0f - z * z ) );
+	const float phi = 2.0f * PI * random.nextFloat();
+	return Vector3( r * cosf( phi ), r * sinf( phi ), z );
+}
+
+bool
+BenchmarkUtil::isCSV( const char * filename )
+{
+	const size_t length = strlen( filename );
+	return length >= 4 && ( strcmp( filename + length - 4, ".csv" ) == 0 || strcmp( filename + length - 4, ".CSV" ) == 0 );
+}
+
+bool
+BenchmarkUtil::loadMesh( TriangleMesh & mesh, const char * filename )
+{
+	char path[256];
+	strncpy( path, filename, sizeof(path) - 1 );
+	path[sizeof(path) - 1] = 0;
+	return mesh.load( path );
+}
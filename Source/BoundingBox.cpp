@@ -1,10 +1,11 @@
 #include "BoundingBox.h"
-#include "BVH.h"
+#include "RenderStats.h"
+#include <new> // must come before DebugMem.h
 #include "DebugMem.h"
 #include <assert.h>
 
-BoundingBox::BoundingBox( Objects * objects, bool isLeaf, Vector3 vecMin, Vector3 vecMax ) :
-BoundingVolume(objects,isLeaf), m_vMin(vecMin), m_vMax(vecMax)
+BoundingBox::BoundingBox( bool isLeaf, Vector3 vecMin, Vector3 vecMax ) :
+BoundingVolume(isLeaf), m_vMin(vecMin), m_vMax(vecMax)
 {
 }
 
@@ -12,10 +13,22 @@ BoundingBox::~BoundingBox()
 {
 }
 
+// DebugMem.h redefines new for leak tracking, which breaks placement new
+#pragma push_macro("new")
+#undef new
+
+BoundingBox *
+BoundingBox::create( MemoryArena & arena, bool isLeaf, Vector3 vecMin, Vector3 vecMax )
+{
+	return new( arena.alloc( sizeof( BoundingBox ) ) ) BoundingBox( isLeaf, vecMin, vecMax );
+}
+
+#pragma pop_macro("new")
+
 bool
-BoundingBox::intersect( HitInfo& result, const Ray& ray, float tMin, float tMax )
+BoundingBox::intersect( const Ray& ray, float tMin, float tMax ) const
 {
-	BVH::intersectBoundingVolume();
+	RenderStats::countBoundingVolumeTest();
 
 	// pre-compute denominators so we don't have to perform expensive divisions
 	float oneOverDX = 1/ray.d.x;
@@ -81,52 +94,7 @@ BoundingBox::intersect( HitInfo& result, const Ray& ray, float tMin, float tMax
 		return false;
 
 	// if we've reached this point, we have an intersection!
-	/*
-	// THIS CODE IS UNNECESSARY UNLESS WE WANT TO ACTUALLY SHADE THE BOUNDING VOLUME
-	// use first intersection point (min) for computing the actual intersection
-	result.t = min;
-	result.P = ray.o + (result.t * ray.d);
-
-	// figure out which plane we intersected
-	BoundingBox::IntersectingPlane plane;
-	if( result.P.x > ( m_vMin.x - epsilon ) && result.P.x < ( m_vMin.x + epsilon ) )
-		plane = XMIN_PLANE;
-	else if( result.P.x > ( m_vMax.x - epsilon ) && result.P.x < ( m_vMax.x + epsilon ) )
-		plane = XMAX_PLANE;
-	else if( result.P.y > ( m_vMin.y - epsilon ) && result.P.y < ( m_vMin.y + epsilon ) )
-		plane = YMIN_PLANE;
-	else if( result.P.y > ( m_vMax.y - epsilon ) && result.P.y < ( m_vMax.y + epsilon ) )
-		plane = YMAX_PLANE;
-	else if( result.P.z > ( m_vMin.z - epsilon ) && result.P.z < ( m_vMin.z + epsilon ) )
-		plane = ZMIN_PLANE;
-	else
-		plane = ZMAX_PLANE;
-
-	result.N = getPlaneNormal( plane );
-	result.material = this->m_material;
-	// END UNNECESSARY CODE
-	*/
-
-	bool intersectionFound = false;
-	// the bounding volume was hit; we must check intersections with all of its children
-	for( size_t i = 0; i < m_children.size(); i++ )
-	{
-		HitInfo childResult;
-		if( m_children[i]->intersect( childResult, ray, tMin, tMax ) )
-		{
-			if( !intersectionFound || childResult.t < result.t )
-			{
-				result.t = childResult.t;
-				result.P = childResult.P;
-				result.N = childResult.N;
-				result.material = childResult.material;
-				intersectionFound = true;
-			}
-		}
-	}
-
-	// if we wanted to render the largest bounding box, we'd just return true :)
-	return intersectionFound;
+	return true;
 }
 
 Vector3
@@ -207,7 +175,7 @@ BoundingBox::renderGL()
 		glEnd();
 	}
 
-	for( size_t i = 0; i < m_children.size(); i++ )
+	for( int i = 0; i < m_numChildren; i++ )
 	{
 		m_children[i]->renderGL();
 	}
@@ -1,34 +1,32 @@
 #include "BoundingVolume.h"
 #include "DebugMem.h"
 
-BoundingVolume::BoundingVolume( Objects * objects, bool isLeaf ) :
-m_bIsLeaf( isLeaf )
+#include <assert.h>
+
+BoundingVolume::BoundingVolume( bool isLeaf ) :
+m_bIsLeaf( isLeaf ), m_numChildren( 0 ), m_firstPrimitive( 0 ), m_numPrimitives( 0 )
 { 
-	// now add each bounded object to this bounding volume
-	for( size_t i = 0; i < objects->size(); i++ )
-	{
-		m_children.push_back( (*objects)[i] );
-	}
+	for( int i = 0; i < NUM_NODE_CHILDREN; i++ )
+		m_children[i] = NULL;
 }
 
 BoundingVolume::~BoundingVolume()
 {
-	for( unsigned int i = 0; i < m_children.size(); i++ )
-	{
-		if( m_children[i] )
-		{
-			delete m_children[i];
-			m_children[i] = NULL;
-		}
-	}
+	// children and primitives aren't owned by the volume; see the class comment
+}
 
-	m_children.clear();
+void
+BoundingVolume::addChild( BoundingVolume * child )
+{
+	assert( m_numChildren < NUM_NODE_CHILDREN );
+	m_children[m_numChildren++] = child;
 }
 
 void
-BoundingVolume::addChild( Object * child )
+BoundingVolume::setPrimitives( unsigned int first, unsigned int count )
 {
-	m_children.push_back( child );
+	m_firstPrimitive = first;
+	m_numPrimitives = count;
 }
 
 void
@@ -46,12 +44,10 @@ BoundingVolume::calcNumNodesAndLeaves( int * numNodesPtr, int * numLeavesPtr )
 	// not a leaf, so loop through all children as well
 	else
 	{
-		for( size_t i = 0; i < m_children.size(); i++ )
+		for( int i = 0; i < m_numChildren; i++ )
 		{
-			// since this isn't a leaf, each child is a bounding volume
-			BoundingVolume * childBV = ( BoundingVolume * )m_children[i];
-			childBV->calcNumNodesAndLeaves( numNodesPtr, numLeavesPtr );
+			m_children[i]->calcNumNodesAndLeaves( numNodesPtr, numLeavesPtr );
 		}
 	}
 
-}
\ No newline at end of file
+}
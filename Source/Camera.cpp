@@ -6,9 +6,14 @@
 #include "Scene.h"
 #include "Console.h" 
 #include "OpenGL.h"
+#include "Random.h"
 #include "DebugMem.h"
 #include <time.h>
 
+#if USE_SSE
+#include <xmmintrin.h>
+#endif
+
 Camera * g_camera = 0;
 
 static bool firstRayTrace = true; 
@@ -24,10 +29,13 @@ Camera::Camera() :
     m_lookAt(FLT_MAX, FLT_MAX, FLT_MAX),
     m_fov((45.)*(PI/180.)),
 	m_focal_plane_distance(10.0f),
-	m_aperture(0.1f)
+	m_aperture(0.1f),
+	m_frame_dirty(true),
+	m_frame_width(0),
+	m_frame_height(0),
+	m_pixel_size(0)
 {
     calcLookAt();
-	calcAperturePlaneAxes();
 }
 
 
@@ -98,9 +106,12 @@ Camera::drawGL()
 }
 
 
-Ray
-Camera::eyeRay(int x, int y, int imageWidth, int imageHeight)
+void
+Camera::calcFrame(int imageWidth, int imageHeight)
 {
+    if (!m_frame_dirty && imageWidth == m_frame_width && imageHeight == m_frame_height)
+        return;
+
     // first compute the camera coordinate system 
     // ------------------------------------------
 
@@ -125,86 +136,134 @@ Camera::eyeRay(int x, int y, int imageWidth, int imageHeight)
 
 
 
-    // transform x and y into camera space 
-    // -----------------------------------
+    // precompute the step between pixels and the direction through pixel (0, 0)'s center
+    // ------------------------------------------------------------------------------
 
-    const float imPlaneUPos = left   + (right - left)*(((float)x+0.5f)/(float)imageWidth); 
-    const float imPlaneVPos = bottom + (top - bottom)*(((float)y+0.5f)/(float)imageHeight); 
+    m_pixel_delta_u = ((right - left)/(float)imageWidth)*uDir;
+    m_pixel_delta_v = ((top - bottom)/(float)imageHeight)*vDir;
+    m_pixel_origin_dir = left*uDir + bottom*vDir - wDir + 0.5f*m_pixel_delta_u + 0.5f*m_pixel_delta_v;
+    m_pixel_size = (top - bottom)/(float)imageHeight;
 
-    return Ray(m_eye, (imPlaneUPos*uDir + imPlaneVPos*vDir - wDir).normalize(), 1.0f);
-}
+    m_lens_axis_u = m_aperture*uDir;
+    m_lens_axis_v = m_aperture*vDir;
 
-bool
-Camera::getFocalPlaneIntersection(Vector3 &desiredFocalPlanePt, const Vector3 hitPt) const
-{
-	/*
-	 * The IDEA:
-	 *
-	 * Equation for a plane: x is in a plane with normal n that contains point p if:
-	 *		dot( n, x - p ) = 0;
-	 * The point on the focal plane that we are interested in can be represented as:
-	 *		cameraEyePt + t * dirToHitPtFromCamera
-	 * for some value of t.
-	 *
-	 * We can combine these two equations to solve for t.
-	 */
-	Vector3 focalPlaneNormal = m_viewDir;
-
-	Vector3 focalPlanePt = m_eye + m_focal_plane_distance * focalPlaneNormal;
-
-	Vector3 dirFromCamera = hitPt - m_eye;
-	dirFromCamera.normalize();
-
-	float t = ( dot( focalPlaneNormal, focalPlanePt ) - dot( focalPlaneNormal, m_eye ) ) / dot( focalPlaneNormal, dirFromCamera );
-
-	// the intersection with the focal plane is AT the camera or behind it
-	if( t <= 0 )
-		return false;
-
-	// calculate the point on the focal plane we are interested in
-	desiredFocalPlanePt = m_eye + t * dirFromCamera;
-	return true;
+    m_frame_width = imageWidth;
+    m_frame_height = imageHeight;
+    m_frame_dirty = false;
 }
 
-Vector3 
-Camera::getRandomApertureSample() const
+Ray
+Camera::eyeRay(int x, int y, int imageWidth, int imageHeight)
 {
-	// randomizer is seeded by Scene.cpp
+    calcFrame(imageWidth, imageHeight);
 
-	float tAxis1 = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
-	float tAxis2 = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
+    Vector3 dir = m_pixel_origin_dir + (float)x*m_pixel_delta_u + (float)y*m_pixel_delta_v;
+    return Ray(m_eye, dir.normalize(), 1.0f);
+}
 
-	// since the random sample can be anywhere within the disc, the t values can range from [-1,1]
-	float posOrNeg = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
-	if( posOrNeg <= 0.5 )
-		tAxis1 *= -1;
-	posOrNeg = rand() / static_cast<double>(RAND_MAX); // yields random value in range [0,1]
-	if( posOrNeg <= 0.5 )
-		tAxis2 *= -1;
+Ray
+Camera::eyeRay(int x, int y, float offsetX, float offsetY, int imageWidth, int imageHeight)
+{
+    calcFrame(imageWidth, imageHeight);
 
-	Vector3 randomSample = m_eye + tAxis1 * m_aperture_plane_axis1 + tAxis2 * m_aperture_plane_axis2;
-	return randomSample;
+    // m_pixel_origin_dir already points at the pixel center
+    Vector3 dir = m_pixel_origin_dir + ((float)x + offsetX - 0.5f)*m_pixel_delta_u + ((float)y + offsetY - 0.5f)*m_pixel_delta_v;
+    return Ray(m_eye, dir.normalize(), 1.0f);
 }
 
 void
-Camera::calcAperturePlaneAxes()
+Camera::eyeRays(Ray * rays, int x0, int y0, int tileWidth, int tileHeight, int imageWidth, int imageHeight)
 {
-	// we need a point in the plane OTHER than the eye point.
-	// we can just use arbitrary values of x and y, and then solve for z such that the point is in the plane
-	Vector3 point1( m_eye.x + 1, m_eye.y + 1, 0 ); // we'll solve for z in a moment...
+    calcFrame(imageWidth, imageHeight);
 
-	// note that m_viewDir is normal to the aperture plane
-	point1.z = m_eye.z - ( m_viewDir.x * ( point1.x - m_eye.x ) - m_viewDir.y * ( point1.y - m_eye.y ) ) / m_viewDir.z;
+    for (int j = 0; j < tileHeight; ++j)
+    {
+        Ray * rowRays = rays + j*tileWidth;
+        const Vector3 rowDir = m_pixel_origin_dir + (float)(y0 + j)*m_pixel_delta_v;
+        int i = 0;
+
+#if USE_SSE
+        // 4 pixels at a time: dir = rowDir + x * deltaU, then normalize
+        const __m128 rowDirX = _mm_set1_ps(rowDir.x);
+        const __m128 rowDirY = _mm_set1_ps(rowDir.y);
+        const __m128 rowDirZ = _mm_set1_ps(rowDir.z);
+        const __m128 deltaUX = _mm_set1_ps(m_pixel_delta_u.x);
+        const __m128 deltaUY = _mm_set1_ps(m_pixel_delta_u.y);
+        const __m128 deltaUZ = _mm_set1_ps(m_pixel_delta_u.z);
+
+        for (; i + 4 <= tileWidth; i += 4)
+        {
+            const float x = (float)(x0 + i);
+            const __m128 px = _mm_set_ps(x + 3.0f, x + 2.0f, x + 1.0f, x);
+
+            __m128 dx = _mm_add_ps(rowDirX, _mm_mul_ps(px, deltaUX));
+            __m128 dy = _mm_add_ps(rowDirY, _mm_mul_ps(px, deltaUY));
+            __m128 dz = _mm_add_ps(rowDirZ, _mm_mul_ps(px, deltaUZ));
+
+            // full precision sqrt/div rather than rsqrt, so the results match eyeRay()
+            const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+            dx = _mm_div_ps(dx, length);
+            dy = _mm_div_ps(dy, length);
+            dz = _mm_div_ps(dz, length);
+
+            float outX[4], outY[4], outZ[4];
+            _mm_storeu_ps(outX, dx);
+            _mm_storeu_ps(outY, dy);
+            _mm_storeu_ps(outZ, dz);
+
+            for (int k = 0; k < 4; ++k)
+            {
+                Ray & ray = rowRays[i + k];
+                ray.o = m_eye;
+                ray.d.set(outX[k], outY[k], outZ[k]);
+                ray.refractiveIndex = 1.0f;
+            }
+        }
+#endif // USE_SSE
 
-	// now we can get our first axis
-	m_aperture_plane_axis1 = point1 - m_eye;
-	m_aperture_plane_axis1.normalize();
+        // whatever is left over (or everything, without SSE)
+        for (; i < tileWidth; ++i)
+        {
+            Vector3 dir = rowDir + (float)(x0 + i)*m_pixel_delta_u;
+            rowRays[i] = Ray(m_eye, dir.normalize(), 1.0f);
+        }
+    }
+}
 
-	// make the second axis orthonormal to the first
-	m_aperture_plane_axis2 = cross( m_viewDir, m_aperture_plane_axis1 );
-	m_aperture_plane_axis2.normalize();
+Ray
+Camera::lensRay(const Ray& pinholeRay, float lensU, float lensV) const
+{
+	// the point on the focal plane (perpendicular to the view direction) that every
+	// ray through this pixel converges on
+	const float t = m_focal_plane_distance / dot( pinholeRay.d, m_viewDir );
+	const Vector3 focalPlanePt = m_eye + t * pinholeRay.d;
+
+	float dx, dy;
+	Random::concentricSampleDisc( lensU, lensV, dx, dy );
+
+	Ray ray;
+	ray.o = m_eye + dx * m_lens_axis_u + dy * m_lens_axis_v;
+	ray.d = focalPlanePt - ray.o;
+	ray.d.normalize();
+	ray.refractiveIndex = pinholeRay.refractiveIndex;
+	return ray;
+}
+
+float
+Camera::circleOfConfusion(const Vector3& pt) const
+{
+	const float depth = dot( pt - m_eye, m_viewDir );
+	if( depth <= 0 )
+		return maxCircleOfConfusion();
+
+	// a point at this depth blurs into a disc of diameter 2 * aperture * |depth - f| / depth
+	// on the focal plane, where one pixel is f * m_pixel_size tall
+	const float blurDiameter = 2.0f * m_aperture * fabs( depth - m_focal_plane_distance ) / depth;
+	return blurDiameter / ( m_focal_plane_distance * m_pixel_size );
+}
 
-	// now make the length of each axis the radius of the aperture
-	m_aperture_plane_axis1 *= m_aperture;
-	m_aperture_plane_axis2 *= m_aperture;
-}
\ No newline at end of file
+float
+Camera::maxCircleOfConfusion() const
+{
+	return 2.0f * m_aperture / ( m_focal_plane_distance * m_pixel_size );
+}
@@ -15,6 +15,7 @@
 #endif
 
 static char __internal_console_buffer__[8192] = {'\0'};
+static int __internal_console_errors__ = 0;
 
 #define TEXT_NORMAL   "\033[0m"
 #define TEXT_RED   "\033[1;31m"
@@ -101,6 +102,12 @@ void error(const char *fmt,...)
 
   cprintf(TEXT_RED"error: "TEXT_NORMAL);
   cprintf(__internal_console_buffer__);
+  __internal_console_errors__++;
+}
+
+int errorCount()
+{
+  return __internal_console_errors__;
 }
 
 void debug(const char *fmt,...)
@@ -0,0 +1,116 @@
+#include "CostMap.h"
+#include "Image.h"
+#include "ImageWriter.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <string>
+#include <stdio.h>
+
+namespace
+{
+
+// black -> blue -> red -> yellow -> white, for t from 0 to 1
+Vector3
+falseColour( float t )
+{
+	static const Vector3 stops[] =
+	{
+		Vector3( 0, 0, 0 ), Vector3( 0, 0, 1 ), Vector3( 1, 0, 0 ), Vector3( 1, 1, 0 ), Vector3( 1, 1, 1 )
+	};
+	const int numSegments = sizeof(stops) / sizeof(stops[0]) - 1;
+
+	t = std::min( std::max( t, 0.0f ), 1.0f ) * numSegments;
+	const int i = std::min( (int)t, numSegments - 1 );
+	const float f = t - i;
+	return stops[i] * ( 1.0f - f ) + stops[i+1] * f;
+}
+
+bool
+writeImage( Image & img, const std::string & filename )
+{
+	ImageWriter * writer = ImageWriter::create( filename.c_str() );
+	const bool ok = writer && writer->open( filename.c_str(), img.width(), img.height() ) && writer->writeImage( img );
+	delete writer;
+	return ok;
+}
+
+} // namespace
+
+
+void
+CostMap::resize( int width, int height )
+{
+	m_width = width;
+	m_height = height;
+	for( int i = 0; i < NUM_METRICS; i++ )
+		m_values[i].assign( width * height, 0.0f );
+}
+
+void
+CostMap::add( int x, int y, const Snapshot& since )
+{
+	const RenderStats::Counters& counters = RenderStats::local();
+	const int i = y * m_width + x;
+
+	m_values[TIME][i] += (float)( ( Timer::now() - since.time ) * 1e9 );
+	m_values[BVH_NODES][i] += (float)( counters.boundingVolumeTests - since.counters.boundingVolumeTests );
+	m_values[PRIMITIVE_TESTS][i] += (float)( counters.primitiveTests - since.counters.primitiveTests );
+	m_values[SHADOW_RAYS][i] += (float)( counters.rays[RenderStats::SHADOW] - since.counters.rays[RenderStats::SHADOW] );
+}
+
+const char *
+CostMap::metricName( int metric )
+{
+	static const char * names[NUM_METRICS] =
+	{
+		"time", "bvh_nodes", "primitive_tests", "shadow_rays"
+	};
+	return metric >= 0 && metric < NUM_METRICS ? names[metric] : "unknown";
+}
+
+bool
+CostMap::write( const char * prefix ) const
+{
+	if( isEmpty() )
+		return false;
+
+	const int numPixels = m_width * m_height;
+	bool ok = true;
+
+	for( int metric = 0; metric < NUM_METRICS; metric++ )
+	{
+		const std::vector<float>& values = m_values[metric];
+
+		// scale to the 99th percentile rather than the maximum, so a few
+		// pathological pixels don't leave the rest of the map black
+		std::vector<float> sorted( values );
+		const int percentile = std::min( numPixels - 1, (int)( numPixels * 0.99f ) );
+		std::nth_element( sorted.begin(), sorted.begin() + percentile, sorted.end() );
+		const float scale = sorted[percentile] > 0.0f ? 1.0f / sorted[percentile] : 0.0f;
+
+		double sum = 0.0;
+		Image raw, colour;
+		raw.resize( m_width, m_height );
+		colour.resize( m_width, m_height );
+		for( int y = 0; y < m_height; y++ )
+		{
+			for( int x = 0; x < m_width; x++ )
+			{
+				const float v = values[y * m_width + x];
+				raw.setPixel( x, y, Vector3( v ) );
+				colour.setPixel( x, y, falseColour( v * scale ) );
+				sum += v;
+			}
+		}
+
+		const std::string name = std::string( prefix ) + "_" + metricName( metric );
+		if( !writeImage( colour, name + ".ppm" ) || !writeImage( raw, name + ".pfm" ) )
+		{
+			ok = false;
+			continue;
+		}
+		printf( "Wrote %s.ppm and .pfm (%.1f per pixel on average, %.1f at the 99th percentile)\n",
+			name.c_str(), sum / numPixels, sorted[percentile] );
+	}
+	return ok;
+}
@@ -0,0 +1,439 @@
+#include "DistributedRenderer.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Image.h"
+#include "Socket.h"
+#include "RenderStats.h"
+#include "ProgressReporter.h"
+#include "Timer.h"
+#include "TraceRecorder.h"
+#include "DebugMem.h"
+#include <deque>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+const unsigned int PROTOCOL_MAGIC = 0x4f52494d; // "MIRO"
+const unsigned int PROTOCOL_VERSION = 2;
+
+enum MessageType
+{
+	MSG_HELLO  = 1, // worker -> coordinator: PROTOCOL_MAGIC, PROTOCOL_VERSION, image width, height
+	MSG_JOB    = 2, // coordinator -> worker: seed
+	MSG_TILE   = 3, // coordinator -> worker: Tile to render
+	MSG_RESULT = 4, // worker -> coordinator: Tile, the RenderStats::Counters for it, then width * height * 3 floats
+	MSG_DONE   = 5  // coordinator -> worker: no more tiles
+};
+
+struct MessageHeader
+{
+	unsigned int type;
+	unsigned int size; // bytes of payload after the header
+};
+
+struct Tile
+{
+	int x, y, width, height;
+};
+
+struct Worker
+{
+	Socket * socket;    // NULL once it's been dropped
+	std::string name;   // its address, which outlives the socket
+	bool ready; // said hello and got the job
+	std::deque<Tile> assigned;
+	int numTiles;
+	int numPixels;
+	RenderStats::Count numRays;
+	double connectTime;
+	double disconnectTime; // when it was dropped
+	double lastResultTime; // when it last sent back a tile (or said hello)
+	int traceLane;  // where its tiles go in the trace
+};
+
+bool
+sendMessage( Socket & socket, unsigned int type, const void * payload, unsigned int size )
+{
+	MessageHeader header;
+	header.type = type;
+	header.size = size;
+	return socket.sendAll( &header, sizeof(header) ) && ( size == 0 || socket.sendAll( payload, size ) );
+}
+
+void
+sleepMilliseconds( int ms )
+{
+#ifdef WIN32
+	Sleep( ms );
+#else
+	usleep( ms * 1000 );
+#endif
+}
+
+// puts the worker's unfinished tiles back at the front of the queue and moves it to
+// dropped, which keeps what it rendered for the statistics
+void
+dropWorker( std::vector<Worker*>& workers, size_t index, std::deque<Tile>& pending,
+	std::vector<Worker*>& dropped, const char * reason )
+{
+	Worker * worker = workers[index];
+
+	printf( "\nWorker %s %s", worker->name.c_str(), reason );
+	if( !worker->assigned.empty() )
+		printf( "; handing its %d tile(s) to the others", (int)worker->assigned.size() );
+	printf( "\n" );
+
+	while( !worker->assigned.empty() )
+	{
+		pending.push_front( worker->assigned.back() );
+		worker->assigned.pop_back();
+	}
+
+	delete worker->socket;
+	worker->socket = NULL;
+	worker->disconnectTime = Timer::now();
+	workers.erase( workers.begin() + index );
+	dropped.push_back( worker );
+}
+
+void
+printWorkerStats( const Worker * worker, double endTime )
+{
+	const float seconds = std::max( (float)( endTime - worker->connectTime ), 0.001f );
+	printf( "\tWorker %s%s: %d tiles, %d pixels, %llu rays in %.2f sec (%.0f pixels/sec, %.0f rays/sec)\n",
+		worker->name.c_str(), worker->socket ? "" : " (dropped)", worker->numTiles, worker->numPixels,
+		worker->numRays, seconds, worker->numPixels / seconds, worker->numRays / seconds );
+}
+
+} // namespace
+
+
+void
+DistributedRenderer::coordinate( unsigned short port, unsigned int seed, Image *img, Scene *scene )
+{
+	Socket listener;
+	if( !Socket::startup() || !listener.listen( port ) )
+		return;
+
+	// the same tiles Scene::renderTiles() would render, on the TILE_SIZE grid
+	int x0, y0, x1, y1;
+	scene->renderWindow( img, x0, y0, x1, y1 );
+
+	std::deque<Tile> pending;
+	for( int tileY = y0 - y0 % TILE_SIZE; tileY < y1; tileY += TILE_SIZE )
+	{
+		for( int tileX = x0 - x0 % TILE_SIZE; tileX < x1; tileX += TILE_SIZE )
+		{
+			Tile tile;
+			tile.x = tileX;
+			tile.y = tileY;
+			tile.width = std::min( TILE_SIZE, img->width() - tileX );
+			tile.height = std::min( TILE_SIZE, img->height() - tileY );
+			pending.push_back( tile );
+		}
+	}
+
+	const int numTiles = (int)pending.size();
+	int numTilesDone = 0;
+	std::vector<Worker*> workers, dropped;
+	std::vector<float> pixels;
+	ProgressReporter progress( "Progress", ( x1 - x0 ) * ( y1 - y0 ), 0, Timer::now() );
+	RenderStats::Count numRays = 0;
+	TraceRate rayRate( "rays/s", 0.0 );
+
+	printf( "Waiting for workers on port %d (%d tiles to render)...\n", port, numTiles );
+
+	while( numTilesDone < numTiles )
+	{
+		// keep every worker busy
+		for( size_t i = 0; i < workers.size(); i++ )
+		{
+			Worker * worker = workers[i];
+			while( worker->ready && !pending.empty() && worker->assigned.size() < DISTRIBUTED_TILES_IN_FLIGHT )
+			{
+				const Tile tile = pending.front();
+				if( !sendMessage( *worker->socket, MSG_TILE, &tile, sizeof(tile) ) )
+					break; // the read below will notice the connection is gone
+				pending.pop_front();
+				worker->assigned.push_back( tile );
+			}
+		}
+
+		std::vector<Socket*> sockets, ready;
+		sockets.push_back( &listener );
+		for( size_t i = 0; i < workers.size(); i++ )
+			sockets.push_back( workers[i]->socket );
+
+		if( !Socket::select( sockets, 1000, ready ) )
+		{
+			fprintf( stderr, "select() failed; giving up on the distributed render\n" );
+			break;
+		}
+
+		for( size_t r = 0; r < ready.size(); r++ )
+		{
+			if( ready[r] == &listener )
+			{
+				Socket * socket = listener.accept();
+				if( socket )
+				{
+					Worker * worker = new Worker;
+					worker->socket = socket;
+					worker->name = socket->peerName();
+					worker->ready = false;
+					worker->numTiles = worker->numPixels = worker->numRays = 0;
+					worker->connectTime = Timer::now();
+					worker->disconnectTime = 0.0;
+					worker->lastResultTime = worker->connectTime;
+					worker->traceLane = -1;
+					workers.push_back( worker );
+				}
+				continue;
+			}
+
+			size_t index = 0;
+			while( index < workers.size() && workers[index]->socket != ready[r] )
+				index++;
+			if( index == workers.size() )
+				continue;
+			Worker * worker = workers[index];
+
+			MessageHeader header;
+			if( !worker->socket->recvAll( &header, sizeof(header) ) )
+			{
+				dropWorker( workers, index, pending, dropped, "disconnected" );
+				continue;
+			}
+
+			if( header.type == MSG_HELLO && header.size == 4 * sizeof(unsigned int) )
+			{
+				unsigned int hello[4];
+				if( !worker->socket->recvAll( hello, sizeof(hello) ) )
+				{
+					dropWorker( workers, index, pending, dropped, "disconnected" );
+					continue;
+				}
+				if( hello[0] != PROTOCOL_MAGIC || hello[1] != PROTOCOL_VERSION ||
+					(int)hello[2] != img->width() || (int)hello[3] != img->height() )
+				{
+					dropWorker( workers, index, pending, dropped, "is rendering a different image (or version); ignoring it" );
+					continue;
+				}
+				if( !sendMessage( *worker->socket, MSG_JOB, &seed, sizeof(seed) ) )
+				{
+					dropWorker( workers, index, pending, dropped, "disconnected" );
+					continue;
+				}
+				worker->ready = true;
+				worker->lastResultTime = Timer::now();
+				if( TraceRecorder::isEnabled() )
+					worker->traceLane = TraceRecorder::newLane( "worker " + worker->name );
+				printf( "\nWorker %s connected\n", worker->name.c_str() );
+			}
+			else if( header.type == MSG_RESULT && header.size >= sizeof(Tile) + sizeof(RenderStats::Counters) )
+			{
+				Tile tile;
+				RenderStats::Counters tileStats;
+				if( !worker->socket->recvAll( &tile, sizeof(tile) ) )
+				{
+					dropWorker( workers, index, pending, dropped, "disconnected" );
+					continue;
+				}
+
+				// the tile has to be one this worker was given, with all of its pixels. the size
+				// comes from the tile as it was handed out, never from what the worker says
+				std::deque<Tile>::iterator it = worker->assigned.begin();
+				while( it != worker->assigned.end() && ( it->x != tile.x || it->y != tile.y ) )
+					++it;
+				if( it == worker->assigned.end() )
+				{
+					dropWorker( workers, index, pending, dropped, "sent back a tile it wasn't given" );
+					continue;
+				}
+				tile = *it;
+				const size_t numFloats = tile.width * tile.height * 3;
+				if( header.size != sizeof(Tile) + sizeof(tileStats) + numFloats * sizeof(float) )
+				{
+					dropWorker( workers, index, pending, dropped, "sent back the wrong number of pixels" );
+					continue;
+				}
+				worker->assigned.erase( it );
+				pixels.resize( numFloats );
+
+				if( !worker->socket->recvAll( &tileStats, sizeof(tileStats) ) ||
+					!worker->socket->recvAll( &pixels[0], numFloats * sizeof(float) ) )
+				{
+					// the tile isn't back, so it goes to the others with the rest
+					worker->assigned.push_front( tile );
+					dropWorker( workers, index, pending, dropped, "disconnected" );
+					continue;
+				}
+
+				// a tile on the edge of a crop window only fills in the pixels inside it
+				for( int j = std::max( y0 - tile.y, 0 ); j < std::min( tile.height, y1 - tile.y ); j++ )
+				{
+					for( int i = std::max( x0 - tile.x, 0 ); i < std::min( tile.width, x1 - tile.x ); i++ )
+					{
+						const float * p = &pixels[3 * ( j * tile.width + i )];
+						img->setPixel( tile.x + i, tile.y + j, Vector3( p[0], p[1], p[2] ) );
+					}
+				}
+				scene->displayRows( img, tile.y, tile.y + tile.height );
+
+				// workers render their tiles one after another, so this one took since the last came back
+				const double now = Timer::now();
+				TraceRecorder::spanOnLane( worker->traceLane, "tile", "render", worker->lastResultTime, now, "x", tile.x, "y", tile.y );
+				worker->lastResultTime = now;
+
+				worker->numTiles++;
+				worker->numPixels += tile.width * tile.height;
+				worker->numRays += tileStats.totalRays();
+				RenderStats::add( tileStats );
+				numRays += tileStats.totalRays();
+				rayRate.update( (double)numRays );
+				numTilesDone++;
+				progress.update( scene->tilePixelsInWindow( img, tile.x, tile.y, tile.width, tile.height ) );
+			}
+			else
+			{
+				dropWorker( workers, index, pending, dropped, "sent something unexpected" );
+			}
+		}
+	}
+
+	progress.done();
+	printf( "Distributed rendering statistics:\n" );
+	const double endTime = Timer::now();
+	int totalTiles = 0, totalPixels = 0;
+	RenderStats::Count totalRays = 0;
+
+	// the workers that were dropped count too, for the tiles they did finish
+	for( size_t i = 0; i < dropped.size(); i++ )
+	{
+		Worker * worker = dropped[i];
+		if( worker->numTiles > 0 )
+		{
+			printWorkerStats( worker, worker->disconnectTime );
+			totalTiles += worker->numTiles;
+			totalPixels += worker->numPixels;
+			totalRays += worker->numRays;
+		}
+		delete worker;
+	}
+
+	for( size_t i = 0; i < workers.size(); i++ )
+	{
+		Worker * worker = workers[i];
+		printWorkerStats( worker, endTime );
+		totalTiles += worker->numTiles;
+		totalPixels += worker->numPixels;
+		totalRays += worker->numRays;
+
+		sendMessage( *worker->socket, MSG_DONE, 0, 0 );
+		delete worker->socket;
+		delete worker;
+	}
+
+	printf( "\tTotal: %d tiles, %d pixels, %llu rays\n", totalTiles, totalPixels, totalRays );
+}
+
+int
+DistributedRenderer::work( const char * host, unsigned short port, Camera *cam, Image *img, Scene *scene )
+{
+	if( !Socket::startup() )
+		return 1;
+
+	// the coordinator may not be up yet
+	Socket socket;
+	const double giveUpTime = Timer::now() + DISTRIBUTED_CONNECT_TIMEOUT;
+	while( !socket.connect( host, port ) )
+	{
+		if( Timer::now() >= giveUpTime )
+			return 1;
+		sleepMilliseconds( 500 );
+	}
+
+	const unsigned int hello[4] = { PROTOCOL_MAGIC, PROTOCOL_VERSION, (unsigned int)img->width(), (unsigned int)img->height() };
+	MessageHeader header;
+	unsigned int seed;
+
+	if( !sendMessage( socket, MSG_HELLO, hello, sizeof(hello) ) ||
+		!socket.recvAll( &header, sizeof(header) ) || header.type != MSG_JOB || header.size != sizeof(seed) ||
+		!socket.recvAll( &seed, sizeof(seed) ) )
+	{
+		fprintf( stderr, "The coordinator at %s:%d didn't accept this worker\n", host, port );
+		return 1;
+	}
+
+	printf( "Connected to coordinator %s; preparing the scene...\n", socket.peerName() );
+
+	// build the photon map from the coordinator's seed, so every worker has the same one
+	scene->setupRender( seed );
+	img->setHDR( true );
+
+	std::vector<float> result;
+	int numTiles = 0;
+
+	while( true )
+	{
+		if( !socket.recvAll( &header, sizeof(header) ) )
+		{
+			fprintf( stderr, "Lost the connection to the coordinator\n" );
+			return 1;
+		}
+
+		if( header.type == MSG_DONE )
+			break;
+
+		Tile tile;
+		if( header.type != MSG_TILE || header.size != sizeof(tile) || !socket.recvAll( &tile, sizeof(tile) ) ||
+			tile.width <= 0 || tile.width > TILE_SIZE || tile.height <= 0 || tile.height > TILE_SIZE ||
+			tile.x < 0 || tile.x + tile.width > img->width() || tile.y < 0 || tile.y + tile.height > img->height() )
+		{
+			fprintf( stderr, "Got a bad message from the coordinator\n" );
+			return 1;
+		}
+
+		// count just this tile's rays
+		RenderStats::local().clear();
+		scene->renderTile( cam, img, tile.x, tile.y, tile.width, tile.height );
+
+		// send back the tile, the rays it took and its float pixels in one message
+		const size_t numFloats = tile.width * tile.height * 3;
+		const size_t prefixFloats = ( sizeof(Tile) + sizeof(RenderStats::Counters) ) / sizeof(float);
+		result.resize( prefixFloats + numFloats );
+		memcpy( &result[0], &tile, sizeof(tile) );
+		memcpy( (char*)&result[0] + sizeof(tile), &RenderStats::local(), sizeof(RenderStats::Counters) );
+
+		for( int j = 0; j < tile.height; j++ )
+		{
+			for( int i = 0; i < tile.width; i++ )
+			{
+				const Vector3 p = img->getPixel( tile.x + i, tile.y + j );
+				float * out = &result[prefixFloats + 3 * ( j * tile.width + i )];
+				out[0] = p.x;
+				out[1] = p.y;
+				out[2] = p.z;
+			}
+		}
+
+		if( !sendMessage( socket, MSG_RESULT, &result[0], (unsigned int)( result.size() * sizeof(float) ) ) )
+		{
+			fprintf( stderr, "Lost the connection to the coordinator\n" );
+			return 1;
+		}
+		numTiles++;
+	}
+
+	printf( "Coordinator is done; rendered %d tiles\n", numTiles );
+	return 0;
+}
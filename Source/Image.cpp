@@ -1,10 +1,15 @@
 #include "Miro.h"
 #include "Image.h"
+#include "MemoryStats.h"
 #include "DebugMem.h"
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
 
+#if USE_SSE
+#include <emmintrin.h>
+#endif
+
 #ifdef WIN32
 // disable useless warnings
 #pragma warning(disable:4996)
@@ -17,31 +22,109 @@ Image::Image()
     m_pixels = 0;
     m_width = 1;
     m_height = 1;
+    m_hdr_pixels = 0;
+    m_sample_counts = 0;
+    m_exposure = 1.0f;
+
+    if (USE_HDR_FRAMEBUFFER)
+        setHDR(true);
 }
 
 Image::~Image()
 {
     if (m_pixels)
+    {
         delete [] m_pixels;
+        MemoryStats::remove(MemoryStats::IMAGES, m_width*m_height*sizeof(Pixel));
+    }
+    // setHDR(false) would tone map them first
+    if (m_hdr_pixels)
+    {
+        delete [] m_hdr_pixels;
+        delete [] m_sample_counts;
+        MemoryStats::remove(MemoryStats::IMAGES, m_width*m_height*(3*sizeof(float) + sizeof(unsigned int)));
+    }
 }
 
 void Image::resize(int width, int height)
 {
     if (m_pixels)
+    {
         delete [] m_pixels;
+        MemoryStats::remove(MemoryStats::IMAGES, m_width*m_height*sizeof(Pixel));
+    }
     m_pixels = 0;
     m_pixels = new Pixel[width*height];
+    MemoryStats::add(MemoryStats::IMAGES, width*height*sizeof(Pixel));
     memset(m_pixels, 0, width*height*sizeof(Pixel));
+    const int oldWidth = m_width, oldHeight = m_height;
     m_width = width;
     m_height = height;
+
+    if (isHDR())
+    {
+        // reallocate the float buffer for the new size (nothing in it is worth keeping)
+        delete [] m_hdr_pixels;
+        delete [] m_sample_counts;
+        MemoryStats::remove(MemoryStats::IMAGES, oldWidth*oldHeight*(3*sizeof(float) + sizeof(unsigned int)));
+        m_hdr_pixels = 0;
+        m_sample_counts = 0;
+        setHDR(true);
+    }
+}
+
+void Image::setHDR(bool hdr)
+{
+    if (hdr == isHDR())
+        return;
+
+    if (hdr)
+    {
+        m_hdr_pixels = new float[m_width*m_height*3];
+        m_sample_counts = new unsigned int[m_width*m_height];
+        MemoryStats::add(MemoryStats::IMAGES, m_width*m_height*(3*sizeof(float) + sizeof(unsigned int)));
+
+        // start from whatever the 8-bit pixels hold
+        for (int i = 0; i < m_width*m_height; i++)
+        {
+            m_hdr_pixels[3*i+0] = m_pixels ? m_pixels[i].r / 255.0f : 0.0f;
+            m_hdr_pixels[3*i+1] = m_pixels ? m_pixels[i].g / 255.0f : 0.0f;
+            m_hdr_pixels[3*i+2] = m_pixels ? m_pixels[i].b / 255.0f : 0.0f;
+            m_sample_counts[i] = 0;
+        }
+    }
+    else
+    {
+        // bake the current HDR values into the 8-bit pixels before dropping them
+        toneMap(0, m_height);
+
+        delete [] m_hdr_pixels;
+        delete [] m_sample_counts;
+        MemoryStats::remove(MemoryStats::IMAGES, m_width*m_height*(3*sizeof(float) + sizeof(unsigned int)));
+        m_hdr_pixels = 0;
+        m_sample_counts = 0;
+    }
 }
 
 void Image::clear(const Vector3& c)
+{
+    clear(c, 0, 0, m_width, m_height);
+}
+
+void Image::clear(const Vector3& c, int x0, int y0, int x1, int y1)
 {
     // should be bg color
-    for (int y=0; y<m_height; y++)
-        for (int x=0; x<m_width; x++)
+    for (int y=y0; y<y1; y++)
+    {
+        for (int x=x0; x<x1; x++)
+        {
             setPixel(x, y, c);
+
+            // the background doesn't count as a sample; the first addSample() replaces it
+            if (isHDR())
+                m_sample_counts[y*m_width+x] = 0;
+        }
+    }
 }
 
 // map floating point values to byte values for pixels
@@ -54,9 +137,20 @@ unsigned char Map(float r)
 
 void Image::setPixel(int x, int y, const Vector3& p)
 {
-    // do some tone mapping
     if (x >= 0 && x < m_width && y < m_height && y >= 0)
     {
+        if (isHDR())
+        {
+            // tone mapping waits until the pixel is displayed or written
+            float * hdr = &m_hdr_pixels[3*(y*m_width+x)];
+            hdr[0] = p.x;
+            hdr[1] = p.y;
+            hdr[2] = p.z;
+            m_sample_counts[y*m_width+x] = 1;
+            return;
+        }
+
+        // do some tone mapping
         m_pixels[y*m_width+x].r = Map(p.x);
         m_pixels[y*m_width+x].g = Map(p.y);
         m_pixels[y*m_width+x].b = Map(p.z);
@@ -65,15 +159,120 @@ void Image::setPixel(int x, int y, const Vector3& p)
 
 void Image::setPixel(int x, int y, const Pixel& p)
 {
-    // do some tone mapping
     if (x >= 0 && x < m_width && y < m_height && y >= 0)
     {
-        m_pixels[y*m_width+x]= p;
+        if (isHDR())
+            setPixel(x, y, Vector3(p.r / 255.0f, p.g / 255.0f, p.b / 255.0f));
+        else
+            m_pixels[y*m_width+x]= p;
+    }
+}
+
+void Image::addSample(int x, int y, const Vector3& p)
+{
+    if (!isHDR())
+    {
+        setPixel(x, y, p);
+        return;
+    }
+
+    if (x >= 0 && x < m_width && y < m_height && y >= 0)
+    {
+        float * hdr = &m_hdr_pixels[3*(y*m_width+x)];
+        unsigned int & count = m_sample_counts[y*m_width+x];
+
+        if (count == 0)
+        {
+            hdr[0] = p.x;
+            hdr[1] = p.y;
+            hdr[2] = p.z;
+        }
+        else
+        {
+            hdr[0] += p.x;
+            hdr[1] += p.y;
+            hdr[2] += p.z;
+        }
+        count++;
+    }
+}
+
+Vector3 Image::getPixel(int x, int y) const
+{
+    const int i = y*m_width+x;
+    if (!isHDR())
+        return Vector3(m_pixels[i].r / 255.0f, m_pixels[i].g / 255.0f, m_pixels[i].b / 255.0f);
+
+    const float scale = m_sample_counts[i] > 1 ? 1.0f / m_sample_counts[i] : 1.0f;
+    return Vector3(m_hdr_pixels[3*i+0], m_hdr_pixels[3*i+1], m_hdr_pixels[3*i+2]) * scale;
+}
+
+int Image::numSamples(int x, int y) const
+{
+    return isHDR() ? (int)m_sample_counts[y*m_width+x] : 1;
+}
+
+void Image::toneMap(int y0, int y1)
+{
+    if (!isHDR())
+        return;
+
+    for (int y = y0; y < y1; y++)
+    {
+        const float * hdr = &m_hdr_pixels[3*y*m_width];
+        const unsigned int * counts = &m_sample_counts[y*m_width];
+        unsigned char * out = (unsigned char*)&m_pixels[y*m_width];
+        int x = 0;
+
+#if USE_SSE
+        // 4 pixels (12 floats, 3 registers) at a time. each pixel is scaled by
+        // exposure / numSamples, clamped to [0, 255] and truncated like Map()
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 maxValue = _mm_set1_ps(255.0f);
+
+        for (; x + 4 <= m_width; x += 4)
+        {
+            float s[4];
+            for (int k = 0; k < 4; k++)
+                s[k] = 255.0f * m_exposure / (counts[x+k] > 1 ? counts[x+k] : 1);
+
+            // (rgb rgb rgb rgb) lines up with these per-pixel scales
+            const __m128 scale0 = _mm_set_ps(s[1], s[0], s[0], s[0]);
+            const __m128 scale1 = _mm_set_ps(s[2], s[2], s[1], s[1]);
+            const __m128 scale2 = _mm_set_ps(s[3], s[3], s[3], s[2]);
+
+            const float * in = &hdr[3*x];
+            __m128 v0 = _mm_mul_ps(_mm_loadu_ps(in + 0), scale0);
+            __m128 v1 = _mm_mul_ps(_mm_loadu_ps(in + 4), scale1);
+            __m128 v2 = _mm_mul_ps(_mm_loadu_ps(in + 8), scale2);
+
+            v0 = _mm_min_ps(_mm_max_ps(v0, zero), maxValue);
+            v1 = _mm_min_ps(_mm_max_ps(v1, zero), maxValue);
+            v2 = _mm_min_ps(_mm_max_ps(v2, zero), maxValue);
+
+            // 12 ints -> 12 bytes (the values are already in range, so the saturating packs don't change them)
+            const __m128i lo = _mm_packs_epi32(_mm_cvttps_epi32(v0), _mm_cvttps_epi32(v1));
+            const __m128i hi = _mm_packs_epi32(_mm_cvttps_epi32(v2), _mm_setzero_si128());
+            unsigned char bytes[16];
+            _mm_storeu_si128((__m128i*)bytes, _mm_packus_epi16(lo, hi));
+            memcpy(&out[3*x], bytes, 12);
+        }
+#endif // USE_SSE
+
+        // whatever is left over (or everything, without SSE)
+        for (; x < m_width; x++)
+        {
+            const float scale = m_exposure / (counts[x] > 1 ? counts[x] : 1);
+            out[3*x+0] = Map(hdr[3*x+0] < 0.0f ? 0.0f : hdr[3*x+0] * scale);
+            out[3*x+1] = Map(hdr[3*x+1] < 0.0f ? 0.0f : hdr[3*x+1] * scale);
+            out[3*x+2] = Map(hdr[3*x+2] < 0.0f ? 0.0f : hdr[3*x+2] * scale);
+        }
     }
 }
 
 void Image::drawScanline(int y)
 {
+    toneMap(y, y+1);
     glRasterPos2f(-1, -1 + 2*y / (float)m_height);
     glDrawPixels(m_width, 1, GL_RGB, GL_UNSIGNED_BYTE, &m_pixels[y*m_width]);
 }
@@ -86,6 +285,7 @@ void Image::draw()
 
 void Image::writePPM(char* pcFile)
 {
+    toneMap(0, m_height);
     writePPM(pcFile, (unsigned char*)m_pixels, m_width, m_height);
 }
 
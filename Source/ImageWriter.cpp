@@ -0,0 +1,247 @@
+#include "ImageWriter.h"
+#include "Image.h"
+#include "Profiler.h"
+#include "DebugMem.h"
+#include <string.h>
+#include <ctype.h>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+namespace
+{
+
+// case insensitive check of a file name's extension (ext includes the dot)
+bool
+hasExtension( const char * filename, const char * ext )
+{
+	const size_t nameLength = strlen( filename );
+	const size_t extLength = strlen( ext );
+	if( nameLength < extLength )
+		return false;
+
+	const char * nameExt = filename + nameLength - extLength;
+	for( size_t i = 0; i < extLength; i++ )
+	{
+		if( tolower( nameExt[i] ) != tolower( ext[i] ) )
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+
+ImageWriter*
+ImageWriter::create( const char * filename )
+{
+	if( hasExtension( filename, ".ppm" ) )
+		return new PPMWriter;
+	if( hasExtension( filename, ".pfm" ) )
+		return new PFMWriter;
+	if( hasExtension( filename, ".tga" ) )
+		return new TGAWriter;
+
+	fprintf( stderr, "Don't know how to write image file %s (use .ppm, .pfm or .tga)\n", filename );
+	return 0;
+}
+
+ImageWriter::ImageWriter() : m_file(0), m_width(0), m_height(0), m_next_row(0)
+{
+}
+
+ImageWriter::~ImageWriter()
+{
+	close();
+}
+
+bool
+ImageWriter::open( const char * filename, int width, int height )
+{
+	PROFILE_SCOPE(IMAGE_WRITE);
+
+	close();
+
+	m_file = fopen( filename, "wb" );
+	if( !m_file )
+	{
+		fprintf( stderr, "Couldn't open image file %s for writing\n", filename );
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_next_row = 0;
+
+	if( !writeHeader() )
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool
+ImageWriter::writeScanline( Image & img, int y )
+{
+	PROFILE_SCOPE(IMAGE_WRITE);
+
+	if( !m_file || y != m_next_row || y >= m_height )
+		return false;
+
+	if( !writeRow( img, y ) )
+	{
+		fprintf( stderr, "Error writing image row %d\n", y );
+		return false;
+	}
+
+	// so whatever has been rendered so far is on disk if we crash
+	fflush( m_file );
+	m_next_row++;
+	return true;
+}
+
+bool
+ImageWriter::writeImage( Image & img )
+{
+	while( m_next_row < m_height )
+	{
+		if( !writeScanline( img, m_next_row ) )
+			return false;
+	}
+	return true;
+}
+
+void
+ImageWriter::close()
+{
+	if( m_file )
+	{
+		fclose( m_file );
+		m_file = 0;
+	}
+}
+
+
+//--------------------------------------------------------
+// PPM: rows are stored top down, so each one is seeked to
+
+bool
+PPMWriter::writeHeader()
+{
+	fprintf( m_file, "P6\n%d %d\n255\n", m_width, m_height );
+	m_data_offset = ftell( m_file );
+	return m_data_offset > 0;
+}
+
+bool
+PPMWriter::writeRow( Image & img, int y )
+{
+	const long stride = m_width * 3;
+	if( fseek( m_file, m_data_offset + ( m_height - 1 - y ) * stride, SEEK_SET ) != 0 )
+		return false;
+
+	return fwrite( img.getCharScanline( y ), stride, 1, m_file ) == 1;
+}
+
+
+//--------------------------------------------------------
+// PFM: rows are stored bottom up; a negative scale means little endian floats
+
+bool
+PFMWriter::writeHeader()
+{
+	fprintf( m_file, "PF\n%d %d\n-1.000000\n", m_width, m_height );
+	m_row.resize( m_width * 3 );
+	return true;
+}
+
+bool
+PFMWriter::writeRow( Image & img, int y )
+{
+	for( int x = 0; x < m_width; x++ )
+	{
+		const Vector3 p = img.getPixel( x, y );
+		m_row[3*x+0] = p.x;
+		m_row[3*x+1] = p.y;
+		m_row[3*x+2] = p.z;
+	}
+
+	return fwrite( &m_row[0], sizeof(float), m_row.size(), m_file ) == m_row.size();
+}
+
+
+//--------------------------------------------------------
+// TGA: type 10 (run length encoded true color), 24 bit BGR, bottom-left origin.
+// each row is encoded on its own so packets never span scanlines
+
+bool
+TGAWriter::writeHeader()
+{
+	unsigned char header[18];
+	memset( header, 0, sizeof(header) );
+
+	header[2] = 10; // RLE true color
+	header[12] = m_width & 0xff;
+	header[13] = ( m_width >> 8 ) & 0xff;
+	header[14] = m_height & 0xff;
+	header[15] = ( m_height >> 8 ) & 0xff;
+	header[16] = 24; // bits per pixel
+	header[17] = 0;  // bottom-left origin, no alpha
+
+	if( m_width > 0xffff || m_height > 0xffff )
+	{
+		fprintf( stderr, "Image is too large for a TGA file\n" );
+		return false;
+	}
+
+	// worst case, every pixel is a literal: one header byte per 128 pixels plus the pixels
+	m_packets.reserve( m_width * 3 + m_width / 128 + 1 );
+	return fwrite( header, sizeof(header), 1, m_file ) == 1;
+}
+
+bool
+TGAWriter::writeRow( Image & img, int y )
+{
+	const unsigned char * rgb = img.getCharScanline( y );
+	m_packets.clear();
+
+	int x = 0;
+	while( x < m_width )
+	{
+		// how many pixels starting at x repeat the same color (a packet holds at most 128)
+		int run = 1;
+		while( x + run < m_width && run < 128 &&
+			   memcmp( &rgb[3*x], &rgb[3*(x+run)], 3 ) == 0 )
+			run++;
+
+		if( run > 1 )
+		{
+			m_packets.push_back( (unsigned char)( 0x80 | ( run - 1 ) ) );
+			m_packets.push_back( rgb[3*x+2] );
+			m_packets.push_back( rgb[3*x+1] );
+			m_packets.push_back( rgb[3*x+0] );
+			x += run;
+			continue;
+		}
+
+		// literal packet: gather pixels until the next run of 2 or more starts
+		int count = 1;
+		while( x + count < m_width && count < 128 &&
+			   !( x + count + 1 < m_width && memcmp( &rgb[3*(x+count)], &rgb[3*(x+count+1)], 3 ) == 0 ) )
+			count++;
+
+		m_packets.push_back( (unsigned char)( count - 1 ) );
+		for( int i = 0; i < count; i++ )
+		{
+			m_packets.push_back( rgb[3*(x+i)+2] );
+			m_packets.push_back( rgb[3*(x+i)+1] );
+			m_packets.push_back( rgb[3*(x+i)+0] );
+		}
+		x += count;
+	}
+
+	return fwrite( &m_packets[0], 1, m_packets.size(), m_file ) == m_packets.size();
+}
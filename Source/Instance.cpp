@@ -0,0 +1,100 @@
+#include "Instance.h"
+#include "TriangleMesh.h"
+#include "BVH.h"
+#include "Ray.h"
+#include "DebugMem.h"
+#include <assert.h>
+
+Instance::Instance(TriangleMesh * mesh, const Matrix4x4& xform) :
+    m_mesh(mesh), m_xform(xform), m_inverse_xform(xform)
+{
+	// the mesh's bottom-level BVH must already exist (see TriangleMesh::buildBVH)
+	assert( m_mesh && m_mesh->bvh() );
+
+	m_inverse_xform.invert();
+	m_normal_xform = m_inverse_xform;
+	m_normal_xform.transpose();
+}
+
+Instance::~Instance()
+{
+	// the mesh is shared with other instances, so we don't delete it here
+}
+
+Vector3
+Instance::transformDirection(const Matrix4x4& m, const Vector3& d)
+{
+	// directions ignore the translation part of the matrix
+	Vector4 result = m * Vector4(d.x, d.y, d.z, 0.0f);
+	return Vector3(result.x, result.y, result.z);
+}
+
+void
+Instance::renderGL()
+{
+	// OpenGL wants the matrix in column-major order
+	GLfloat glMatrix[16] = { m_xform.m11, m_xform.m21, m_xform.m31, m_xform.m41,
+	                         m_xform.m12, m_xform.m22, m_xform.m32, m_xform.m42,
+	                         m_xform.m13, m_xform.m23, m_xform.m33, m_xform.m43,
+	                         m_xform.m14, m_xform.m24, m_xform.m34, m_xform.m44 };
+
+	glPushMatrix();
+	glMultMatrixf( glMatrix );
+	m_mesh->bvh()->renderGL();
+	glPopMatrix();
+}
+
+bool
+Instance::intersect(HitInfo& result, const Ray& ray, float tMin, float tMax)
+{
+	// transform the ray into the mesh's object space. the direction is deliberately
+	// not renormalized, so t values are the same in object space and world space.
+	Ray objectRay( m_inverse_xform * ray.o, transformDirection( m_inverse_xform, ray.d ), ray.refractiveIndex );
+
+	if( !m_mesh->bvh()->intersect( result, objectRay, tMin, tMax ) )
+		return false;
+
+	// bring the hit back into world space
+	result.P = ray.o + result.t * ray.d;
+	result.N = transformDirection( m_normal_xform, result.N );
+	result.N.normalize();
+
+	return true;
+}
+
+void
+Instance::getBounds(Vector3& vMin, Vector3& vMax) const
+{
+	Vector3 objMin, objMax;
+	m_mesh->bvh()->getBounds( objMin, objMax );
+
+	// transform all 8 corners of the object space box and bound them in world space
+	for( int i = 0; i < 8; i++ )
+	{
+		Vector3 corner( ( i & 1 ) ? objMax.x : objMin.x,
+		                ( i & 2 ) ? objMax.y : objMin.y,
+		                ( i & 4 ) ? objMax.z : objMin.z );
+		corner = m_xform * corner;
+
+		if( i == 0 )
+		{
+			vMin = vMax = corner;
+			continue;
+		}
+
+		vMin.x = std::min( vMin.x, corner.x );
+		vMin.y = std::min( vMin.y, corner.y );
+		vMin.z = std::min( vMin.z, corner.z );
+		vMax.x = std::max( vMax.x, corner.x );
+		vMax.y = std::max( vMax.y, corner.y );
+		vMax.z = std::max( vMax.z, corner.z );
+	}
+}
+
+Vector3
+Instance::getMidPoint() const
+{
+	Vector3 vMin, vMax;
+	getBounds( vMin, vMax );
+	return ( vMin + vMax ) / 2;
+}
@@ -108,7 +108,7 @@ Lambert::getDiffuseColor( const Ray& ray, const HitInfo& hit, const Scene& scene
 		HitInfo hitInfo;
 
 		// we have a (hard) shadow!
-		if( !pLight->isAreaLight() && scene.trace( hitInfo, shadowRay, epsilon, magnitude ) )
+		if( !pLight->isAreaLight() && scene.trace( hitInfo, shadowRay, RenderStats::SHADOW, epsilon, magnitude ) )
 		{
 			bool inShadow = true;
 			bool hitSomething = true;
@@ -122,7 +122,7 @@ Lambert::getDiffuseColor( const Ray& ray, const HitInfo& hit, const Scene& scene
 				// see if we hit anything else; start tracing from last hit point
 				shadowRay.o = hitInfo.P;
 				magnitude = ( pLight->position() - shadowRay.o ).length();
-				hitSomething = scene.trace( hitInfo, shadowRay, epsilon, magnitude );
+				hitSomething = scene.trace( hitInfo, shadowRay, RenderStats::SHADOW, epsilon, magnitude );
 
 				// if we hit something, put shadow flag back on (if it's refractive, it'll get turned off on the next loop)
 				if( hitSomething )
@@ -190,7 +190,7 @@ Lambert::getIndirectLight( const HitInfo hitInfo, const Scene& scene ) const
 
 		indirectLightingRay.o = hitInfo.P;
 		indirectLightingRay.d = randomDir;
-		if( scene.trace( indirectLightingHit, indirectLightingRay, epsilon, MIRO_TMAX ) )
+		if( scene.trace( indirectLightingHit, indirectLightingRay, RenderStats::PATH, epsilon, MIRO_TMAX ) )
 		{
 			bool hitAreaLight = false;
 
@@ -6,6 +6,7 @@
 #include "Scene.h"
 #include "Ray.h"
 #include "WorleyNoise.h"
+#include "MaterialLibrary.h"
 
 Material::Material()
 {
@@ -54,16 +55,15 @@ Material::loadMaterial( char * fileName )
 	// add .mtl suffix
 	strncpy_s( endStr, 80 - strlen(fileNameWithExt) - 1, ".mtl", _TRUNCATE );
 
-	FILE * fp;
-	fopen_s( &fp, fileNameWithExt, "rb" );
+	FILE * fp = openAsset( fileNameWithExt, "rb" );
 	if( !fp )
 	{
-		debug( "Error: could not open %s for reading.\n", fileNameWithExt );
+		error( "could not open %s for reading.\n", fileNameWithExt );
 		return NULL;
 	}
 
 	Vector3 kd(1), ka(0);
-	bool useBumpMap;
+	bool useBumpMap = false;
 	int octaves, seed; // for bump map noise maker
 	float freq, amp; // for bump map noise maker
 	char buf[80];
@@ -118,20 +118,17 @@ Material::setUseBumpMap( bool useBumpMap, int octaves, float freq, float amp, in
 	// use a bump map for this material
 	if( useBumpMap )
 	{
-		// if we don't already have one, we need to create a noise maker
+		// if we don't already have one, we need a noise maker. these are shared
+		// between materials with the same parameters and owned by the MaterialLibrary
 		if( !m_bump_map_noise_maker )
 		{
-			m_bump_map_noise_maker = new CustomizablePerlinNoise( octaves, freq, amp, seed );
+			m_bump_map_noise_maker = MaterialLibrary::getNoiseMaker( octaves, freq, amp, seed );
 		}
 	}
 	// DON'T use a bump map for this material
 	else
 	{
-		if( m_use_bump_map )
-		{
-			delete m_bump_map_noise_maker;
-			m_bump_map_noise_maker = NULL;
-		}
+		m_bump_map_noise_maker = NULL;
 	}
 
 	m_use_bump_map = useBumpMap;
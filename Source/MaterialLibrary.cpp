@@ -0,0 +1,66 @@
+#include "MaterialLibrary.h"
+#include "DebugMem.h"
+
+MaterialLibrary::MaterialMap MaterialLibrary::m_materials;
+MaterialLibrary::NoiseMakerMap MaterialLibrary::m_noise_makers;
+
+bool
+MaterialLibrary::NoiseParams::operator<( const NoiseParams & other ) const
+{
+	if( octaves != other.octaves )
+		return octaves < other.octaves;
+	if( freq != other.freq )
+		return freq < other.freq;
+	if( amp != other.amp )
+		return amp < other.amp;
+	return seed < other.seed;
+}
+
+Material *
+MaterialLibrary::getMaterial( char * fileName )
+{
+	MaterialMap::iterator it = m_materials.find( fileName );
+	if( it != m_materials.end() )
+		return it->second;
+
+	// first time we've seen this file; parse it. failures are remembered too
+	// so that a missing .mtl file isn't reopened for every usemtl line.
+	Material * material = Material::loadMaterial( fileName );
+	m_materials[fileName] = material;
+
+	return material;
+}
+
+CustomizablePerlinNoise *
+MaterialLibrary::getNoiseMaker( int octaves, float freq, float amp, int seed )
+{
+	NoiseParams params;
+	params.octaves = octaves;
+	params.freq = freq;
+	params.amp = amp;
+	params.seed = seed;
+
+	NoiseMakerMap::iterator it = m_noise_makers.find( params );
+	if( it != m_noise_makers.end() )
+		return it->second;
+
+	CustomizablePerlinNoise * noiseMaker = new CustomizablePerlinNoise( octaves, freq, amp, seed );
+	m_noise_makers[params] = noiseMaker;
+
+	return noiseMaker;
+}
+
+void
+MaterialLibrary::clear()
+{
+	for( MaterialMap::iterator it = m_materials.begin(); it != m_materials.end(); ++it )
+	{
+		if( it->second )
+			delete it->second;
+	}
+	m_materials.clear();
+
+	for( NoiseMakerMap::iterator it = m_noise_makers.begin(); it != m_noise_makers.end(); ++it )
+		delete it->second;
+	m_noise_makers.clear();
+}
@@ -0,0 +1,93 @@
+#include "MemoryArena.h"
+#include "DebugMem.h"
+
+MemoryArena::MemoryArena( MemoryStats::Category category, size_t blockSize ) :
+m_category( category ), m_blockSize( blockSize ), m_currentBlock( 0 ), m_currentOffset( 0 )
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	release();
+}
+
+void *
+MemoryArena::alloc( size_t numBytes )
+{
+	// keep every allocation aligned for SSE types
+	numBytes = ( numBytes + MEMORY_ARENA_ALIGNMENT - 1 ) & ~( size_t )( MEMORY_ARENA_ALIGNMENT - 1 );
+
+	// move on to the next block that can hold this allocation, if this one can't
+	while( m_currentBlock < m_blocks.size() && m_currentOffset + numBytes > m_blocks[m_currentBlock].size )
+	{
+		m_currentBlock++;
+		m_currentOffset = 0;
+	}
+
+	// we've run out of blocks; make a new one (big enough for oversized requests)
+	if( m_currentBlock == m_blocks.size() )
+	{
+		Block block;
+		block.size = numBytes > m_blockSize ? numBytes : m_blockSize;
+		block.data = new char[block.size + MEMORY_ARENA_ALIGNMENT];
+		MemoryStats::add( m_category, block.size + MEMORY_ARENA_ALIGNMENT );
+		m_blocks.push_back( block );
+		m_currentOffset = 0;
+	}
+
+	// new[] only guarantees alignment for the largest fundamental type, so align by hand
+	char * blockStart = m_blocks[m_currentBlock].data;
+	blockStart += ( MEMORY_ARENA_ALIGNMENT - ( size_t )blockStart % MEMORY_ARENA_ALIGNMENT ) % MEMORY_ARENA_ALIGNMENT;
+
+	void * result = blockStart + m_currentOffset;
+	m_currentOffset += numBytes;
+
+	return result;
+}
+
+MemoryArena::Marker
+MemoryArena::mark() const
+{
+	Marker marker;
+	marker.block = m_currentBlock;
+	marker.offset = m_currentOffset;
+	return marker;
+}
+
+void
+MemoryArena::rewind( const Marker & marker )
+{
+	// everything allocated since the marker is now free to be handed out again
+	m_currentBlock = marker.block;
+	m_currentOffset = marker.offset;
+}
+
+void
+MemoryArena::reset()
+{
+	m_currentBlock = 0;
+	m_currentOffset = 0;
+}
+
+void
+MemoryArena::release()
+{
+	for( size_t i = 0; i < m_blocks.size(); i++ )
+	{
+		delete [] m_blocks[i].data;
+		m_blocks[i].data = NULL;
+		MemoryStats::remove( m_category, m_blocks[i].size + MEMORY_ARENA_ALIGNMENT );
+	}
+	m_blocks.clear();
+
+	reset();
+}
+
+size_t
+MemoryArena::bytesReserved() const
+{
+	size_t total = 0;
+	for( size_t i = 0; i < m_blocks.size(); i++ )
+		total += m_blocks[i].size;
+	return total;
+}
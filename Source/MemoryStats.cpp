@@ -0,0 +1,142 @@
+#include "MemoryStats.h"
+#include "Atomic.h"
+#include <new> // must come before DebugMem.h
+#include "DebugMem.h"
+
+size_t MemoryStats::s_current[NUM_CATEGORIES];
+size_t MemoryStats::s_peak[NUM_CATEGORIES];
+size_t MemoryStats::s_current_total = 0;
+size_t MemoryStats::s_peak_total = 0;
+
+namespace
+{
+
+// guards the counts. allocations big enough to count are rare, so it's hardly ever contended
+SpinLock s_lock;
+
+double
+megabytes( size_t bytes )
+{
+	return bytes / ( 1024.0 * 1024.0 );
+}
+
+} // namespace
+
+
+void
+MemoryStats::add( Category category, size_t bytes )
+{
+	s_lock.lock();
+	s_current[category] += bytes;
+	if( s_current[category] > s_peak[category] )
+		s_peak[category] = s_current[category];
+	s_current_total += bytes;
+	if( s_current_total > s_peak_total )
+		s_peak_total = s_current_total;
+	s_lock.unlock();
+}
+
+void
+MemoryStats::remove( Category category, size_t bytes )
+{
+	s_lock.lock();
+	s_current[category] -= bytes;
+	s_current_total -= bytes;
+	s_lock.unlock();
+}
+
+// DebugMem.h redefines new for leak tracking, which breaks ::operator new
+#pragma push_macro("new")
+#undef new
+
+void *
+MemoryStats::allocate( Category category, size_t bytes )
+{
+	void * p = ::operator new( bytes );
+	add( category, bytes );
+	return p;
+}
+
+void
+MemoryStats::deallocate( Category category, void * p, size_t bytes )
+{
+	if( p )
+		remove( category, bytes );
+	::operator delete( p );
+}
+
+#pragma pop_macro("new")
+
+size_t
+MemoryStats::current( Category category )
+{
+	s_lock.lock();
+	const size_t bytes = s_current[category];
+	s_lock.unlock();
+	return bytes;
+}
+
+size_t
+MemoryStats::peak( Category category )
+{
+	s_lock.lock();
+	const size_t bytes = s_peak[category];
+	s_lock.unlock();
+	return bytes;
+}
+
+size_t
+MemoryStats::currentTotal()
+{
+	s_lock.lock();
+	const size_t bytes = s_current_total;
+	s_lock.unlock();
+	return bytes;
+}
+
+size_t
+MemoryStats::peakTotal()
+{
+	s_lock.lock();
+	const size_t bytes = s_peak_total;
+	s_lock.unlock();
+	return bytes;
+}
+
+const char *
+MemoryStats::categoryName( int category )
+{
+	static const char * names[NUM_CATEGORIES] =
+	{
+		"mesh_vertices", "mesh_normals", "mesh_indices", "triangles", "bvh_nodes", "bvh_build",
+		"photon_map", "environment_map", "noise_tables", "images", "materials"
+	};
+	return category >= 0 && category < NUM_CATEGORIES ? names[category] : "unknown";
+}
+
+void
+MemoryStats::print()
+{
+	for( int i = 0; i < NUM_CATEGORIES; i++ )
+	{
+		const size_t peakBytes = peak( (Category)i );
+		if( peakBytes > 0 )
+		{
+			printf( "\t%-16s %10.2f MB (peak %.2f MB)\n", categoryName( i ),
+				megabytes( current( (Category)i ) ), megabytes( peakBytes ) );
+		}
+	}
+	printf( "\t%-16s %10.2f MB (peak %.2f MB)\n", "total", megabytes( currentTotal() ), megabytes( peakTotal() ) );
+}
+
+void
+MemoryStats::writeJSON( FILE * fp, const char * indent )
+{
+	for( int i = 0; i < NUM_CATEGORIES; i++ )
+	{
+		fprintf( fp, "%s\"%s\": {\"current\": %llu, \"peak\": %llu},\n", indent, categoryName( i ),
+			(unsigned long long)current( (Category)i ), (unsigned long long)peak( (Category)i ) );
+	}
+	fprintf( fp, "%s\"total\": {\"current\": %llu, \"peak\": %llu}\n", indent,
+		(unsigned long long)currentTotal(), (unsigned long long)peakTotal() );
+}
@@ -5,7 +5,9 @@
 #include "Image.h"
 #include "DebugMem.h"
 #include "Scene.h"
+#include "MaterialLibrary.h"
 #include <stdlib.h>
+#include <algorithm>
 #include <time.h>
 
 #define ANGFACT     1.0
@@ -37,7 +39,10 @@ MiroWindow::MiroWindow(int * argc, char* argv[]) :
     m_scaleFact(0.1f),
     m_activeButton(0),
     m_mouseX(0),
-    m_mouseY(0)
+    m_mouseY(0),
+    m_selecting(false),
+    m_selectX(0),
+    m_selectY(0)
 {
     // Initialize GLUT
     glutInit(argc, argv);
@@ -78,10 +83,32 @@ MiroWindow::display()
 {
     g_camera->click(g_scene, g_image); // take a snapshot of the scene
 
+    if (m_selecting)
+        drawSelection();
+
     glFinish(); // flush the openGL pipeline
 }
 
 
+void
+MiroWindow::drawSelection()
+{
+    // the ray traced image is drawn with identity matrices, so go from window pixels to [-1,1]
+    const float x0 = 2.0f*m_selectX/g_image->width() - 1;
+    const float y0 = 1 - 2.0f*m_selectY/g_image->height();
+    const float x1 = 2.0f*m_mouseX/g_image->width() - 1;
+    const float y1 = 1 - 2.0f*m_mouseY/g_image->height();
+
+    glColor3f(1, 1, 0);
+    glBegin(GL_LINE_LOOP);
+    glVertex2f(x0, y0);
+    glVertex2f(x1, y0);
+    glVertex2f(x1, y1);
+    glVertex2f(x0, y1);
+    glEnd();
+}
+
+
 void
 MiroWindow::motion(int x, int y)
 {
@@ -138,9 +165,36 @@ MiroWindow::mouse(int button, int state, int x, int y)
         m_mouseX = x;
         m_mouseY = y;
         m_activeButton |= b;       /* set the proper bit   */
+
+        // dragging with the right button over the ray traced image picks a crop window
+        if (b == RIGHT && !g_camera->isOpenGL())
+        {
+            m_selecting = true;
+            m_selectX = x;
+            m_selectY = y;
+        }
     }
     else
+    {
         m_activeButton &= ~b;      /* clear the proper bit */
+
+        if (b == RIGHT && m_selecting)
+        {
+            m_selecting = false;
+
+            // re-render just the selected rectangle; the BVH and photon map are kept
+            const int x0 = std::max(0, std::min(m_selectX, x));
+            const int y0 = std::max(0, std::min(m_selectY, y));
+            const int x1 = std::min(g_image->width(), std::max(m_selectX, x));
+            const int y1 = std::min(g_image->height(), std::max(m_selectY, y));
+            if (x1 - x0 > 1 && y1 - y0 > 1)
+            {
+                g_scene->setCropWindow(x0, y0, x1 - x0, y1 - y0, g_image);
+                g_scene->raytraceImage(g_camera, g_image);
+            }
+            glutPostRedisplay();
+        }
+    }
 }
 
 void
@@ -167,9 +221,12 @@ MiroWindow::keyboard(unsigned char key, int x, int y)
 				g_image = NULL;
 			}
 
+			MaterialLibrary::clear();
 
+#ifdef WIN32
 			// did we have any memory leaks?
 			_CrtDumpMemoryLeaks();
+#endif
             exit(0);
         break;
 
@@ -202,6 +259,13 @@ MiroWindow::keyboard(unsigned char key, int x, int y)
             g_camera->setRenderer(Camera::RENDER_OPENGL);
         break;
 
+        case 'c':
+        case 'C':
+            // the next ray trace renders the whole image again
+            g_scene->setCropWindow(0, 0, 0, 0, g_image);
+            printf("Crop window cleared\n");
+        break;
+
         case '+':
             m_scaleFact *= 1.5;
         break;
@@ -1,4 +1,5 @@
 #include "PFMLoader.h"
+#include "Miro.h"
 #include "DebugMem.h"
 #include <stdexcept>
 
@@ -50,7 +51,7 @@ PFMLoader::readPFMImage(const char * filename, int * width, int * height)
 
     try
     {
-        fopen_s(&infile, filename, "rb");
+        infile = openAsset(filename, "rb");
         if (!infile)
             throw std::runtime_error("cannot open file.");
 
@@ -0,0 +1,163 @@
+#include "PerfCounters.h"
+#include "Atomic.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+
+#if USE_PERF_COUNTERS && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#define HAVE_PERF_EVENTS 1
+#else
+#define HAVE_PERF_EVENTS 0
+#endif
+
+bool PerfCounters::s_enabled = false;
+bool PerfCounters::s_available = false;
+
+namespace
+{
+
+#if HAVE_PERF_EVENTS
+// the calling thread's group of counters (the cycles counter leads it):
+// -2 until it's been opened, -1 if it couldn't be
+THREAD_LOCAL int s_group = -2;
+// errno from the perf_event_open() that failed, if one did
+THREAD_LOCAL int s_open_error = 0;
+
+const unsigned long long EVENTS[PerfCounters::NUM_COUNTERS] =
+{
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// opens the counter, in the group unless it's the leader (-1). returns its file descriptor, or -1
+int
+openCounter( unsigned long long event, int group )
+{
+	perf_event_attr attr;
+	memset( &attr, 0, sizeof(attr) );
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = event;
+	attr.read_format = PERF_FORMAT_GROUP;
+	// user mode only, which perf_event_paranoid 2 still allows
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int)syscall( __NR_perf_event_open, &attr, 0, -1, group, 0 );
+}
+
+// opens the calling thread's counters, if it hasn't tried yet. returns the group, or -1
+int
+threadGroup()
+{
+	if( s_group != -2 )
+		return s_group;
+
+	int fds[PerfCounters::NUM_COUNTERS];
+	int opened = 0;
+	for( ; opened < PerfCounters::NUM_COUNTERS; opened++ )
+	{
+		fds[opened] = openCounter( EVENTS[opened], opened == 0 ? -1 : fds[0] );
+		if( fds[opened] < 0 )
+		{
+			// before close() can change it
+			s_open_error = errno;
+			break;
+		}
+	}
+
+	// all or nothing, so every Sample has every counter
+	if( opened < PerfCounters::NUM_COUNTERS )
+	{
+		for( int i = 0; i < opened; i++ )
+			close( fds[i] );
+		s_group = -1;
+	}
+	else
+	{
+		s_group = fds[0];
+	}
+	return s_group;
+}
+#endif
+
+} // namespace
+
+
+void
+PerfCounters::Sample::clear()
+{
+	memset( this, 0, sizeof(*this) );
+}
+
+void
+PerfCounters::Sample::addDifference( const Sample& start, const Sample& end )
+{
+	for( int i = 0; i < NUM_COUNTERS; i++ )
+		values[i] += end.values[i] - start.values[i];
+}
+
+void
+PerfCounters::Sample::addDifference( const Sample& start, const Sample& end, double fraction )
+{
+	for( int i = 0; i < NUM_COUNTERS; i++ )
+		values[i] += (unsigned long long)( ( end.values[i] - start.values[i] ) * fraction + 0.5 );
+}
+
+double
+PerfCounters::Sample::ipc() const
+{
+	return values[CYCLES] > 0 ? (double)values[INSTRUCTIONS] / values[CYCLES] : 0.0;
+}
+
+bool
+PerfCounters::enable()
+{
+	s_enabled = true;
+#if HAVE_PERF_EVENTS
+	s_available = threadGroup() >= 0;
+	if( !s_available )
+	{
+		fprintf( stderr, "Hardware performance counters are unavailable (perf_event_open: %s); "
+			"reporting times only\n", strerror( s_open_error ) );
+	}
+#else
+	s_available = false;
+	fprintf( stderr, "Hardware performance counters need Linux's perf_event; reporting times only\n" );
+#endif
+	return s_available;
+}
+
+bool
+PerfCounters::read( Sample& sample )
+{
+	if( !isAvailable() )
+		return false;
+
+#if HAVE_PERF_EVENTS
+	const int group = threadGroup();
+	if( group < 0 )
+		return false;
+
+	// PERF_FORMAT_GROUP: the number of counters, then their values in the order they were opened
+	unsigned long long buffer[1 + NUM_COUNTERS];
+	if( ::read( group, buffer, sizeof(buffer) ) != (ssize_t)sizeof(buffer) || buffer[0] != NUM_COUNTERS )
+		return false;
+	memcpy( sample.values, buffer + 1, sizeof(sample.values) );
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char *
+PerfCounters::counterName( int counter )
+{
+	static const char * names[NUM_COUNTERS] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+	return counter >= 0 && counter < NUM_COUNTERS ? names[counter] : "unknown";
+}
@@ -1,5 +1,7 @@
 #include "PhotonMap.h"
 #include "Miro.h"
+#include "Profiler.h"
+#include "MemoryStats.h"
 
 /* This is the constructor for the photon map.
  * To create the photon map it is necessary to specify the
@@ -10,10 +12,12 @@ PhotonMap :: PhotonMap( const int max_phot )
 //************************************************
 {
   stored_photons = 0;
+  half_stored_photons = 0; // lookups before balance() mustn't walk a tree that isn't there
   prev_scale = 1;
   max_photons = max_phot;
 
   photons = (Photon*)malloc( sizeof( Photon ) * ( max_photons+1 ) );
+  MemoryStats::add( MemoryStats::PHOTON_MAP, sizeof( Photon ) * ( max_photons+1 ) );
 
   if (photons == NULL) {
     fprintf(stderr,"Out of memory initializing photon map\n");
@@ -42,6 +46,7 @@ PhotonMap :: ~PhotonMap()
 //*************************
 {
   free( photons );
+  MemoryStats::remove( MemoryStats::PHOTON_MAP, sizeof( Photon ) * ( max_photons+1 ) );
 }
 
 
@@ -69,6 +74,8 @@ void PhotonMap :: irradiance_estimate(
   const int nphotons ) const     // number of photons to use
 //**********************************************
 {
+  PROFILE_SCOPE(PHOTON_GATHER);
+
   irrad[0] = irrad[1] = irrad[2] = 0.0;
 
   NearestPhotons np;
@@ -281,6 +288,9 @@ void PhotonMap :: balance(void)
     // allocate two temporary arrays for the balancing procedure
     Photon **pa1 = (Photon**)malloc(sizeof(Photon*)*(stored_photons+1));
     Photon **pa2 = (Photon**)malloc(sizeof(Photon*)*(stored_photons+1));
+    // they're only around while balancing, but they raise the peak
+    const size_t tempBytes = 2*sizeof(Photon*)*(stored_photons+1);
+    MemoryStats::add( MemoryStats::PHOTON_MAP, tempBytes );
 
     for (int i=0; i<=stored_photons; i++)
       pa2[i] = &photons[i];
@@ -312,12 +322,84 @@ void PhotonMap :: balance(void)
       j = d;
     }
     free(pa1);
+    MemoryStats::remove( MemoryStats::PHOTON_MAP, tempBytes );
   }
 
   half_stored_photons = stored_photons/2-1;
 }
 
 
+/* save writes the balanced photon map to a binary file so
+ * a resumed render doesn't have to shoot the photons again
+ */
+//************************************************
+int PhotonMap :: save( const char *filename ) const
+//************************************************
+{
+  FILE *fp = fopen( filename, "wb" );
+  if (fp == NULL) {
+    fprintf(stderr,"Couldn't open photon map file %s for writing\n", filename);
+    return 0;
+  }
+
+  const char magic[8] = { 'P','H','O','T','O','N','S','1' };
+  int ok = fwrite( magic, sizeof(magic), 1, fp ) == 1 &&
+           fwrite( &max_photons, sizeof(int), 1, fp ) == 1 &&
+           fwrite( &stored_photons, sizeof(int), 1, fp ) == 1 &&
+           fwrite( &half_stored_photons, sizeof(int), 1, fp ) == 1 &&
+           fwrite( &prev_scale, sizeof(int), 1, fp ) == 1 &&
+           fwrite( bbox_min, sizeof(float), 3, fp ) == 3 &&
+           fwrite( bbox_max, sizeof(float), 3, fp ) == 3 &&
+           fwrite( photons, sizeof(Photon), stored_photons+1, fp ) == (size_t)(stored_photons+1);
+
+  fclose( fp );
+  return ok;
+}
+
+
+/* load reads back a photon map written by save
+ */
+//*****************************************************
+PhotonMap *PhotonMap :: load( const char *filename )
+//*****************************************************
+{
+  FILE *fp = fopen( filename, "rb" );
+  if (fp == NULL) {
+    fprintf(stderr,"Couldn't open photon map file %s\n", filename);
+    return NULL;
+  }
+
+  char magic[8];
+  int max_phot, stored;
+  if (fread( magic, sizeof(magic), 1, fp ) != 1 || memcmp( magic, "PHOTONS1", 8 ) != 0 ||
+      fread( &max_phot, sizeof(int), 1, fp ) != 1 ||
+      fread( &stored, sizeof(int), 1, fp ) != 1 ||
+      stored < 0 || stored > max_phot) {
+    fprintf(stderr,"%s is not a photon map file\n", filename);
+    fclose( fp );
+    return NULL;
+  }
+
+  PhotonMap *map = new PhotonMap( max_phot );
+  map->stored_photons = stored;
+
+  int ok = fread( &map->half_stored_photons, sizeof(int), 1, fp ) == 1 &&
+           fread( &map->prev_scale, sizeof(int), 1, fp ) == 1 &&
+           fread( map->bbox_min, sizeof(float), 3, fp ) == 3 &&
+           fread( map->bbox_max, sizeof(float), 3, fp ) == 3 &&
+           fread( map->photons, sizeof(Photon), stored+1, fp ) == (size_t)(stored+1);
+
+  fclose( fp );
+
+  if (!ok) {
+    fprintf(stderr,"Photon map file %s is truncated\n", filename);
+    delete map;
+    return NULL;
+  }
+  return map;
+}
+
+
 #define swap(ph,a,b) { Photon *ph2=ph[a]; ph[a]=ph[b]; ph[b]=ph2; }
 
 // median_split splits the photon array into two separate
@@ -0,0 +1,190 @@
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+THREAD_LOCAL Profiler::Totals Profiler::s_local;
+Profiler::Totals Profiler::s_total;
+SpinLock Profiler::s_lock;
+
+void
+Profiler::Totals::clear()
+{
+	memset( this, 0, sizeof(*this) );
+}
+
+void
+Profiler::Totals::add( const Totals& other )
+{
+	for( int i = 0; i < NUM_PHASES; i++ )
+	{
+		seconds[i] += other.seconds[i];
+		calls[i] += other.calls[i];
+		for( int c = 0; c < PerfCounters::NUM_COUNTERS; c++ )
+			counters[i].values[c] += other.counters[i].values[c];
+		// memory isn't a total; take the most
+		memory[i] = std::max( memory[i], other.memory[i] );
+		peakMemory[i] = std::max( peakMemory[i], other.peakMemory[i] );
+	}
+}
+
+void
+Profiler::merge()
+{
+	s_lock.lock();
+	s_total.add( s_local );
+	s_lock.unlock();
+
+	s_local.clear();
+}
+
+void
+Profiler::reset()
+{
+	s_lock.lock();
+	s_total.clear();
+	s_lock.unlock();
+
+	s_local.clear();
+}
+
+Profiler::Totals
+Profiler::total()
+{
+	s_lock.lock();
+	const Totals total = s_total;
+	s_lock.unlock();
+
+	return total;
+}
+
+void
+Profiler::addPerPixelCounters( const PerfCounters::Sample& start, const PerfCounters::Sample& end,
+	double seconds, const double secondsBefore[NUM_PHASES] )
+{
+	if( seconds <= 0.0 )
+		return;
+	for( int i = 0; i < NUM_PHASES; i++ )
+	{
+		if( !isPerPixel( i ) )
+			continue;
+		// phases nest, so these add up to more than the whole when they're inside one another
+		const double share = ( s_local.seconds[i] - secondsBefore[i] ) / seconds;
+		s_local.counters[i].addDifference( start, end, std::min( std::max( share, 0.0 ), 1.0 ) );
+	}
+}
+
+const char *
+Profiler::phaseName( int phase )
+{
+	static const char * names[NUM_PHASES] =
+	{
+		"scene_load", "obj_parse", "bvh_build", "photon_emission", "photon_balance",
+		"primary_tracing", "shading", "photon_gather", "image_write"
+	};
+	return phase >= 0 && phase < NUM_PHASES ? names[phase] : "unknown";
+}
+
+void
+Profiler::print()
+{
+	if( !USE_PROFILER )
+		return;
+
+	const Totals totals = total();
+	for( int i = 0; i < NUM_PHASES; i++ )
+	{
+		if( totals.calls[i] == 0 )
+			continue;
+		printf( "\t%-16s %10.4f seconds (%llu calls)", phaseName( i ), totals.seconds[i], totals.calls[i] );
+		if( !isPerPixel( i ) )
+		{
+			printf( ", %.2f MB in use after (peak %.2f MB)", totals.memory[i] / ( 1024.0 * 1024.0 ),
+				totals.peakMemory[i] / ( 1024.0 * 1024.0 ) );
+		}
+		printf( "\n" );
+		if( PerfCounters::isAvailable() )
+		{
+			const PerfCounters::Sample & c = totals.counters[i];
+			printf( "\t%-16s %10.2f IPC, %llu cache misses, %llu branch misses\n", "", c.ipc(),
+				c.values[PerfCounters::CACHE_MISSES], c.values[PerfCounters::BRANCH_MISSES] );
+		}
+	}
+}
+
+bool
+Profiler::writeJSON( const char * filename, int width, int height, unsigned int seed, double renderSeconds )
+{
+	FILE * fp = fopen( filename, "w" );
+	if( !fp )
+	{
+		fprintf( stderr, "Couldn't open profile file %s for writing\n", filename );
+		return false;
+	}
+
+	const Totals totals = total();
+	const RenderStats::Counters counters = RenderStats::total();
+
+	fprintf( fp, "{\n" );
+	fprintf( fp, "  \"width\": %d,\n", width );
+	fprintf( fp, "  \"height\": %d,\n", height );
+	fprintf( fp, "  \"seed\": %u,\n", seed );
+	fprintf( fp, "  \"render_seconds\": %.6f,\n", renderSeconds );
+	fprintf( fp, "  \"perf_counters\": %s,\n", PerfCounters::isAvailable() ? "true" : "false" );
+
+	fprintf( fp, "  \"phases\": {\n" );
+	for( int i = 0; i < NUM_PHASES; i++ )
+	{
+		fprintf( fp, "    \"%s\": {\"seconds\": %.6f, \"calls\": %llu", phaseName( i ), totals.seconds[i], totals.calls[i] );
+		if( !isPerPixel( i ) )
+		{
+			fprintf( fp, ", \"memory_bytes\": %llu, \"peak_memory_bytes\": %llu", (unsigned long long)totals.memory[i],
+				(unsigned long long)totals.peakMemory[i] );
+		}
+		// the counters are left out, rather than zero, when there weren't any
+		if( PerfCounters::isAvailable() )
+		{
+			for( int c = 0; c < PerfCounters::NUM_COUNTERS; c++ )
+				fprintf( fp, ", \"%s\": %llu", PerfCounters::counterName( c ), totals.counters[i].values[c] );
+			fprintf( fp, ", \"ipc\": %.4f", totals.counters[i].ipc() );
+		}
+		fprintf( fp, "}%s\n", i + 1 < NUM_PHASES ? "," : "" );
+	}
+	fprintf( fp, "  },\n" );
+
+	// ray type names have spaces; keys use underscores like the phases
+	fprintf( fp, "  \"rays\": {\n" );
+	for( int i = 0; i < RenderStats::NUM_RAY_TYPES; i++ )
+	{
+		char name[64];
+		strncpy( name, RenderStats::rayTypeName( i ), sizeof(name) - 1 );
+		name[sizeof(name) - 1] = 0;
+		for( char * c = name; *c; c++ )
+		{
+			if( *c == ' ' )
+				*c = '_';
+		}
+		fprintf( fp, "    \"%s\": %llu,\n", name, counters.rays[i] );
+	}
+	fprintf( fp, "    \"total\": %llu\n", counters.totalRays() );
+	fprintf( fp, "  },\n" );
+
+	fprintf( fp, "  \"bounding_volume_tests\": %llu,\n", counters.boundingVolumeTests );
+	fprintf( fp, "  \"primitive_tests\": %llu,\n", counters.primitiveTests );
+
+	fprintf( fp, "  \"memory\": {\n" );
+	MemoryStats::writeJSON( fp, "    " );
+	fprintf( fp, "  }\n" );
+	fprintf( fp, "}\n" );
+
+	const bool ok = !ferror( fp );
+	fclose( fp );
+	return ok;
+}
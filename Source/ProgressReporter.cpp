@@ -0,0 +1,64 @@
+#include "ProgressReporter.h"
+#include "Atomic.h"
+#include "DebugMem.h"
+#include <stdio.h>
+
+ProgressReporter::ProgressReporter( const char * title, int total, int alreadyDone, double startTime ) :
+	m_title(title),
+	m_total(total),
+	m_already_done(alreadyDone),
+	m_start_time(startTime),
+	m_run_start_time(Timer::now()),
+	m_last_print(0),
+	m_done(alreadyDone),
+	m_printing(0)
+{
+}
+
+void
+ProgressReporter::update( int numUnits )
+{
+	atomicAdd( &m_done, numUnits );
+
+	// whoever gets here first prints (if it's time); everyone else just carries on
+	if( !atomicCompareAndSwap( &m_printing, 0, 1 ) )
+		return;
+
+	const double now = Timer::now();
+	if( now - m_last_print >= PROGRESS_PRINT_INTERVAL )
+	{
+		print( now );
+		m_last_print = now;
+	}
+
+	atomicCompareAndSwap( &m_printing, 1, 0 );
+}
+
+void
+ProgressReporter::done()
+{
+	print( Timer::now() );
+	printf( "\n" );
+}
+
+void
+ProgressReporter::print( double now )
+{
+	const int done = m_done;
+	const int doneThisRun = done - m_already_done;
+	const double runSeconds = now - m_run_start_time;
+
+	if( m_total > 0 )
+	{
+		// what's left costs what the units so far did on average
+		const double secondsLeft = doneThisRun > 0 ? ( m_total - done ) * runSeconds / doneThisRun : 0.0;
+
+		printf( "\r%s: %.3f%%, Time elapsed: %.4f sec, Est. time left: %.4f sec          \r",
+			m_title, done * 100.0f / m_total, now - m_start_time, secondsLeft );
+	}
+	else
+	{
+		printf( "\r%s: %d done, Time elapsed: %.4f sec          \r", m_title, done, now - m_start_time );
+	}
+	fflush( stdout );
+}
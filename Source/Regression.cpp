@@ -0,0 +1,272 @@
+#include "Regression.h"
+#include "Miro.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Image.h"
+#include "ImageWriter.h"
+#include "PFMLoader.h"
+#include "MaterialLibrary.h"
+#include "RenderOptions.h"
+#include "RenderStats.h"
+#include "Timer.h"
+#include "Console.h"
+#include "Assignment0.h"
+#include "Assignment2.h"
+#include "Assignment3.h"
+#include "Assignment4.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+namespace
+{
+
+void makeSpiral()           {Assignment0 a; a.makeSpiralScene();}
+void makeTeapot()           {Assignment2 a; a.makeTeapotScene();}
+void makeBunny()            {Assignment2 a; a.makeBunny1Scene();}
+void makeCornell()          {Assignment3 a; a.makeCornellScene();}
+void makeDiffuseTeapot()    {Assignment3 a; a.makeTeapotScene(Material::DIFFUSE);}
+void makePond()             {Assignment4 a; a.makePondScene();}
+
+struct ReferenceScene
+{
+	const char * name;
+	void (*make)(); // sets up g_scene, g_camera and g_image
+};
+
+const ReferenceScene SCENES[] =
+{
+	{"spiral", makeSpiral},
+	{"teapot", makeTeapot},
+	{"bunny", makeBunny},
+	{"cornell", makeCornell},
+	{"teapot_diffuse", makeDiffuseTeapot},
+	{"pond", makePond}
+};
+const int NUM_SCENES = sizeof(SCENES) / sizeof(SCENES[0]);
+
+// how a scene's render compared
+struct Outcome
+{
+	const char * name;
+	const char * verdict;
+	double psnr;
+	double seconds;
+	double raysPerSecond;
+	double baselineRaysPerSecond;
+};
+
+bool
+fileExists( const std::string & filename )
+{
+	FILE * fp = fopen( filename.c_str(), "rb" );
+	if( fp )
+		fclose( fp );
+	return fp != 0;
+}
+
+// what the window would show: clamped to [0, 1]
+float
+displayed( float value )
+{
+	return value < 0.0f ? 0.0f : ( value > 1.0f ? 1.0f : value );
+}
+
+// the PSNR in dB of img against the reference (and the RMSE), or false if they're different sizes
+bool
+compareImages( Image & img, const Vector3 * reference, int width, int height, double & rmse, double & psnr )
+{
+	if( width != img.width() || height != img.height() )
+		return false;
+
+	double sumSquares = 0.0;
+	for( int y = 0; y < height; y++ )
+	{
+		for( int x = 0; x < width; x++ )
+		{
+			const Vector3 p = img.getPixel( x, y );
+			const Vector3 & r = reference[y * width + x];
+			for( int c = 0; c < 3; c++ )
+			{
+				const double d = displayed( p[c] ) - displayed( r[c] );
+				sumSquares += d * d;
+			}
+		}
+	}
+
+	rmse = sqrt( sumSquares / ( width * height * 3 ) );
+	// identical images have no noise at all
+	psnr = rmse > 0.0 ? 20.0 * log10( 1.0 / rmse ) : 999.0;
+	return true;
+}
+
+bool
+writeReference( Image & img, const std::string & imageFile, const std::string & baselineFile, double seconds, double raysPerSecond )
+{
+	ImageWriter * writer = ImageWriter::create( imageFile.c_str() );
+	const bool wroteImage = writer && writer->open( imageFile.c_str(), img.width(), img.height() ) && writer->writeImage( img );
+	delete writer;
+	if( !wroteImage )
+		return false;
+
+	FILE * fp = fopen( baselineFile.c_str(), "w" );
+	if( !fp )
+	{
+		fprintf( stderr, "Couldn't open %s for writing\n", baselineFile.c_str() );
+		return false;
+	}
+	fprintf( fp, "%.6f %.1f\n", seconds, raysPerSecond );
+	const bool ok = !ferror( fp );
+	fclose( fp );
+	return ok;
+}
+
+bool
+readBaseline( const std::string & baselineFile, double & seconds, double & raysPerSecond )
+{
+	FILE * fp = fopen( baselineFile.c_str(), "r" );
+	if( !fp )
+		return false;
+	const bool ok = fscanf( fp, "%lf %lf", &seconds, &raysPerSecond ) == 2;
+	fclose( fp );
+	return ok;
+}
+
+} // namespace
+
+
+bool
+Regression::run( const char * directory, bool update, float throughputTolerance )
+{
+	if( throughputTolerance < 0.0f )
+		throughputTolerance = REGRESS_THROUGHPUT_TOLERANCE;
+
+	// every scene renders the same way every time, with nothing written but the references
+	g_options.headless = true;
+	g_options.fixedSeed = true;
+	g_options.seed = REGRESS_SEED;
+	g_options.outputFile = 0;
+
+	std::vector<Outcome> outcomes;
+	bool passed = true;
+
+	for( int i = 0; i < NUM_SCENES; i++ )
+	{
+		printf( "\n=== %s ===\n", SCENES[i].name );
+		const int errorsBefore = errorCount();
+		SCENES[i].make();
+		g_image->resize( REGRESS_IMAGE_SIZE, REGRESS_IMAGE_SIZE );
+		// a mesh or material that didn't load leaves a scene that renders (and matches a
+		// reference made the same way) but tests nothing
+		const bool loaded = errorCount() == errorsBefore && g_scene->bvh().root() != NULL;
+
+		Outcome outcome;
+		outcome.name = SCENES[i].name;
+		outcome.seconds = 0.0;
+		outcome.raysPerSecond = 0.0;
+		if( loaded )
+		{
+			// build the photon map (if the scene has one) first, so only the rendering is timed.
+			// every run renders the same image with the same rays; the fastest counts
+			g_scene->setupRender( REGRESS_SEED );
+			double totalSeconds = 0.0;
+			for( int run = 0; run < REGRESS_NUM_RUNS || totalSeconds < REGRESS_MIN_SECONDS; run++ )
+			{
+				g_image->clear( g_camera->bgColor() );
+				Timer timer;
+				g_scene->raytraceImage( g_camera, g_image );
+				const double seconds = timer.elapsed();
+				if( run == 0 || seconds < outcome.seconds )
+					outcome.seconds = seconds;
+				totalSeconds += seconds;
+			}
+			outcome.raysPerSecond = RenderStats::total().totalRays() / std::max( outcome.seconds, 1e-6 );
+		}
+		outcome.psnr = 0.0;
+		outcome.baselineRaysPerSecond = 0.0;
+
+		const std::string path = std::string( directory ) + "/" + SCENES[i].name;
+		const std::string imageFile = path + ".pfm";
+		const std::string baselineFile = path + ".txt";
+
+		double baselineSeconds;
+		if( !loaded )
+		{
+			outcome.verdict = "FAIL (the scene didn't load)";
+			passed = false;
+		}
+		else if( update || !fileExists( imageFile ) || !readBaseline( baselineFile, baselineSeconds, outcome.baselineRaysPerSecond ) )
+		{
+			if( writeReference( *g_image, imageFile, baselineFile, outcome.seconds, outcome.raysPerSecond ) )
+			{
+				outcome.verdict = "new reference";
+			}
+			else
+			{
+				outcome.verdict = "FAIL (couldn't write the reference)";
+				passed = false;
+			}
+			outcome.baselineRaysPerSecond = outcome.raysPerSecond;
+		}
+		else
+		{
+			int width, height;
+			double rmse;
+			Vector3 * reference = PFMLoader::readPFMImage( imageFile.c_str(), &width, &height );
+			if( !reference || !compareImages( *g_image, reference, width, height, rmse, outcome.psnr ) )
+			{
+				outcome.verdict = "FAIL (bad reference image)";
+				passed = false;
+			}
+			else if( outcome.psnr < REGRESS_MIN_PSNR )
+			{
+				outcome.verdict = "FAIL (image)";
+				passed = false;
+			}
+			else if( outcome.raysPerSecond < outcome.baselineRaysPerSecond * ( 1.0 - throughputTolerance / 100.0 ) )
+			{
+				outcome.verdict = "FAIL (throughput)";
+				passed = false;
+			}
+			else
+			{
+				outcome.verdict = "pass";
+			}
+			delete [] reference;
+		}
+		outcomes.push_back( outcome );
+
+		delete g_scene;
+		g_scene = NULL;
+		delete g_camera;
+		g_camera = NULL;
+		delete g_image;
+		g_image = NULL;
+		MaterialLibrary::clear();
+	}
+
+	printf( "\nRegression results (at least %.1f dB PSNR, at most %.0f%% slower than the baseline):\n",
+		REGRESS_MIN_PSNR, throughputTolerance );
+	for( size_t i = 0; i < outcomes.size(); i++ )
+	{
+		const Outcome & o = outcomes[i];
+		const double change = o.baselineRaysPerSecond > 0.0 ? ( o.raysPerSecond / o.baselineRaysPerSecond - 1.0 ) * 100.0 : 0.0;
+		// a new reference has nothing to be compared with
+		char psnr[32] = "-";
+		if( o.psnr > 0.0 )
+			sprintf( psnr, "%.1f", o.psnr );
+		printf( "\t%-16s %7s dB %8.3f sec %12.0f rays/sec (%+6.1f%%)  %s\n", o.name, psnr, o.seconds,
+			o.raysPerSecond, change, o.verdict );
+	}
+	printf( "%s\n", passed ? "All scenes passed" : "Some scenes FAILED" );
+
+	return passed;
+}
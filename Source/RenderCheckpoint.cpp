@@ -0,0 +1,200 @@
+#include "RenderCheckpoint.h"
+#include "Image.h"
+#include "AccumulationBuffer.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#ifdef WIN32
+#include <windows.h>
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+namespace
+{
+
+const char CHECKPOINT_MAGIC[8] = { 'M','I','R','O','C','K','P','T' };
+const unsigned int CHECKPOINT_VERSION = 1;
+
+template <class T> bool
+writeValue( FILE * fp, const T & value )
+{
+	return fwrite( &value, sizeof(T), 1, fp ) == 1;
+}
+
+template <class T> bool
+readValue( FILE * fp, T & value )
+{
+	return fread( &value, sizeof(T), 1, fp ) == 1;
+}
+
+} // namespace
+
+
+RenderCheckpoint::RenderCheckpoint() :
+	mode(TILES),
+	seed(0),
+	width(0),
+	height(0),
+	pass(0),
+	row(0),
+	elapsedSeconds(0.0f)
+{
+}
+
+bool
+RenderCheckpoint::save( const char * filename, Image & img, const AccumulationBuffer * accumulation ) const
+{
+	if( !img.isHDR() )
+	{
+		fprintf( stderr, "Can't checkpoint an 8-bit image\n" );
+		return false;
+	}
+
+	// write everything to a temporary file first so the old checkpoint is good until the new one is
+	const std::string tempFile = std::string( filename ) + ".tmp";
+	FILE * fp = fopen( tempFile.c_str(), "wb" );
+	if( !fp )
+	{
+		fprintf( stderr, "Couldn't open checkpoint file %s for writing\n", tempFile.c_str() );
+		return false;
+	}
+
+	const size_t numPixels = width*height;
+	const unsigned int photonMapFileLength = (unsigned int)photonMapFile.size();
+
+	bool ok = fwrite( CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC), 1, fp ) == 1 &&
+		writeValue( fp, CHECKPOINT_VERSION ) &&
+		writeValue( fp, mode ) &&
+		writeValue( fp, seed ) &&
+		writeValue( fp, width ) &&
+		writeValue( fp, height ) &&
+		writeValue( fp, pass ) &&
+		writeValue( fp, row ) &&
+		writeValue( fp, elapsedSeconds ) &&
+		writeValue( fp, photonMapFileLength ) &&
+		( photonMapFileLength == 0 || fwrite( photonMapFile.c_str(), photonMapFileLength, 1, fp ) == 1 ) &&
+		fwrite( img.getFloatPixels(), sizeof(float), numPixels*3, fp ) == numPixels*3 &&
+		fwrite( img.getSampleCounts(), sizeof(unsigned int), numPixels, fp ) == numPixels;
+
+	if( ok && mode == ADAPTIVE )
+		ok = accumulation && accumulation->write( fp );
+
+	ok = ( fclose( fp ) == 0 ) && ok;
+
+	if( !ok )
+	{
+		fprintf( stderr, "Error writing checkpoint file %s\n", tempFile.c_str() );
+		remove( tempFile.c_str() );
+		return false;
+	}
+
+	// replace the old checkpoint in one step, so there's always a whole one on disk.
+	// rename() won't replace an existing file on Windows, but MoveFileEx can
+#ifdef WIN32
+	if( !MoveFileExA( tempFile.c_str(), filename, MOVEFILE_REPLACE_EXISTING ) )
+#else
+	if( rename( tempFile.c_str(), filename ) != 0 )
+#endif
+	{
+		fprintf( stderr, "Couldn't rename %s to %s\n", tempFile.c_str(), filename );
+		return false;
+	}
+	return true;
+}
+
+bool
+RenderCheckpoint::load( const char * filename, Image & img, AccumulationBuffer * accumulation )
+{
+	FILE * fp = fopen( filename, "rb" );
+	if( !fp )
+	{
+		// a save that didn't get to replace the checkpoint leaves its data in the temporary file
+		// (a partly written one is caught below, like any truncated checkpoint)
+		const std::string tempFile = std::string( filename ) + ".tmp";
+		fp = fopen( tempFile.c_str(), "rb" );
+		if( !fp )
+		{
+			fprintf( stderr, "Couldn't open checkpoint file %s\n", filename );
+			return false;
+		}
+		fprintf( stderr, "Checkpoint file %s is missing; resuming from %s\n", filename, tempFile.c_str() );
+	}
+
+	char magic[8];
+	unsigned int version = 0;
+	RenderCheckpoint loaded;
+	unsigned int photonMapFileLength = 0;
+
+	bool ok = fread( magic, sizeof(magic), 1, fp ) == 1 &&
+		memcmp( magic, CHECKPOINT_MAGIC, sizeof(magic) ) == 0 &&
+		readValue( fp, version ) && version == CHECKPOINT_VERSION &&
+		readValue( fp, loaded.mode ) &&
+		readValue( fp, loaded.seed ) &&
+		readValue( fp, loaded.width ) &&
+		readValue( fp, loaded.height ) &&
+		readValue( fp, loaded.pass ) &&
+		readValue( fp, loaded.row ) &&
+		readValue( fp, loaded.elapsedSeconds ) &&
+		readValue( fp, photonMapFileLength );
+
+	if( !ok )
+	{
+		fprintf( stderr, "%s is not a checkpoint file (or is from a different version)\n", filename );
+		fclose( fp );
+		return false;
+	}
+
+	if( loaded.width != img.width() || loaded.height != img.height() )
+	{
+		fprintf( stderr, "Checkpoint %s is %dx%d but the image is %dx%d\n", filename,
+			loaded.width, loaded.height, img.width(), img.height() );
+		fclose( fp );
+		return false;
+	}
+
+	if( photonMapFileLength > 0 )
+	{
+		std::vector<char> name( photonMapFileLength );
+		ok = fread( &name[0], photonMapFileLength, 1, fp ) == 1;
+		if( ok )
+			loaded.photonMapFile.assign( &name[0], photonMapFileLength );
+	}
+
+	// read the pixels into temporary buffers so a truncated file leaves img as it was
+	const size_t numPixels = loaded.width*loaded.height;
+	std::vector<float> floatPixels( numPixels*3 );
+	std::vector<unsigned int> sampleCounts( numPixels );
+
+	ok = ok &&
+		fread( &floatPixels[0], sizeof(float), numPixels*3, fp ) == numPixels*3 &&
+		fread( &sampleCounts[0], sizeof(unsigned int), numPixels, fp ) == numPixels;
+
+	if( ok && loaded.mode == ADAPTIVE )
+	{
+		if( accumulation )
+		{
+			accumulation->resize( loaded.width, loaded.height );
+			ok = accumulation->read( fp );
+		}
+		else
+			ok = false;
+	}
+
+	fclose( fp );
+
+	if( !ok )
+	{
+		fprintf( stderr, "Checkpoint file %s is truncated\n", filename );
+		return false;
+	}
+
+	img.setHDR( true );
+	memcpy( img.getFloatPixels(), &floatPixels[0], numPixels*3*sizeof(float) );
+	memcpy( img.getSampleCounts(), &sampleCounts[0], numPixels*sizeof(unsigned int) );
+
+	*this = loaded;
+	return true;
+}
@@ -0,0 +1,329 @@
+#include "RenderOptions.h"
+#include "Regression.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+RenderOptions g_options;
+
+RenderOptions::RenderOptions() :
+	outputFile(0),
+	headless(false),
+	checkpointFile(0),
+	resume(false),
+	fixedSeed(false),
+	seed(0),
+	coordinatorPort(0),
+	workerHost(0),
+	workerPort(0),
+	cropX(0),
+	cropY(0),
+	cropWidth(0),
+	cropHeight(0),
+	profileFile(0),
+	perfCounters(false),
+	traceFile(0),
+	heatmapPrefix(0),
+	benchmarkFile(0),
+	shadingBenchmarkFile(0),
+	regressDirectory(0),
+	regressUpdate(false),
+	regressTolerance(-1.0f),
+	bvhAnalysisFile(0)
+{
+}
+
+bool
+RenderOptions::parse( int * argc, char * argv[] )
+{
+	int numKept = 1;
+
+	for( int i = 1; i < *argc; i++ )
+	{
+		if( strcmp( argv[i], "-o" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-o needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			outputFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-headless" ) == 0 )
+		{
+			headless = true;
+		}
+		else if( strcmp( argv[i], "-checkpoint" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-checkpoint needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			checkpointFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-resume" ) == 0 )
+		{
+			resume = true;
+		}
+		else if( strcmp( argv[i], "-seed" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-seed needs a number\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			fixedSeed = true;
+			seed = (unsigned int)strtoul( argv[++i], 0, 10 );
+		}
+		else if( strcmp( argv[i], "-coordinator" ) == 0 )
+		{
+			const int port = i + 1 < *argc ? atoi( argv[i+1] ) : 0;
+			if( port <= 0 || port > 65535 )
+			{
+				fprintf( stderr, "-coordinator needs a port number\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			coordinatorPort = (unsigned short)port;
+			i++;
+		}
+		else if( strcmp( argv[i], "-worker" ) == 0 )
+		{
+			// split host:port in place
+			char * colon = i + 1 < *argc ? strrchr( argv[i+1], ':' ) : 0;
+			const int port = colon ? atoi( colon + 1 ) : 0;
+			if( port <= 0 || port > 65535 )
+			{
+				fprintf( stderr, "-worker needs <host>:<port>\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			*colon = 0;
+			workerHost = argv[++i];
+			workerPort = (unsigned short)port;
+		}
+		else if( strcmp( argv[i], "-crop" ) == 0 )
+		{
+			if( i + 4 >= *argc )
+			{
+				fprintf( stderr, "-crop needs <x> <y> <width> <height>\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			cropX = atoi( argv[i+1] );
+			cropY = atoi( argv[i+2] );
+			cropWidth = atoi( argv[i+3] );
+			cropHeight = atoi( argv[i+4] );
+			if( cropX < 0 || cropY < 0 || cropWidth <= 0 || cropHeight <= 0 )
+			{
+				fprintf( stderr, "-crop needs a position that isn't negative and a width and height over 0\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			i += 4;
+		}
+		else if( strcmp( argv[i], "-profile" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-profile needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			profileFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-perf-counters" ) == 0 )
+		{
+			perfCounters = true;
+		}
+		else if( strcmp( argv[i], "-trace" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-trace needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			traceFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-heatmap" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-heatmap needs a file name prefix\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			heatmapPrefix = argv[++i];
+		}
+		else if( strcmp( argv[i], "-benchmark" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-benchmark needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			benchmarkFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-benchmark-shading" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-benchmark-shading needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			shadingBenchmarkFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-regress" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-regress needs a directory\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			regressDirectory = argv[++i];
+		}
+		else if( strcmp( argv[i], "-regress-update" ) == 0 )
+		{
+			regressUpdate = true;
+		}
+		else if( strcmp( argv[i], "-regress-tolerance" ) == 0 )
+		{
+			if( i + 1 >= *argc || atof( argv[i+1] ) < 0.0 )
+			{
+				fprintf( stderr, "-regress-tolerance needs a percentage\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			regressTolerance = (float)atof( argv[++i] );
+		}
+		else if( strcmp( argv[i], "-bvh-analysis" ) == 0 )
+		{
+			if( i + 1 >= *argc )
+			{
+				fprintf( stderr, "-bvh-analysis needs a file name\n" );
+				printUsage( argv[0] );
+				return false;
+			}
+			bvhAnalysisFile = argv[++i];
+		}
+		else if( strcmp( argv[i], "-help" ) == 0 || strcmp( argv[i], "-h" ) == 0 )
+		{
+			printUsage( argv[0] );
+			return false;
+		}
+		else
+		{
+			// not ours; leave it for GLUT
+			argv[numKept++] = argv[i];
+		}
+	}
+
+	*argc = numKept;
+	argv[numKept] = 0;
+
+	if( headless && !outputFile && !workerHost )
+	{
+		fprintf( stderr, "-headless needs an output file (-o)\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	if( coordinatorPort && workerHost )
+	{
+		fprintf( stderr, "-coordinator and -worker can't be used together\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	if( ( regressUpdate || regressTolerance >= 0.0f ) && !regressDirectory )
+	{
+		fprintf( stderr, "-regress-update and -regress-tolerance need -regress\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	// the workers' pixels are measured in other processes
+	if( heatmapPrefix && coordinatorPort )
+	{
+		fprintf( stderr, "-heatmap can't be used with -coordinator\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	// checkpoints only know how far down the whole image a render got
+	if( cropWidth > 0 && checkpointFile )
+	{
+		fprintf( stderr, "-crop can't be used with -checkpoint\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	if( resume && !checkpointFile )
+	{
+		fprintf( stderr, "-resume needs a checkpoint file (-checkpoint)\n" );
+		printUsage( argv[0] );
+		return false;
+	}
+
+	return true;
+}
+
+void
+RenderOptions::printUsage( const char * program )
+{
+	printf( "usage: %s [options]\n", program );
+	printf( "\t-o <file>     write the ray traced image to file (.ppm, .pfm or .tga),\n" );
+	printf( "\t              a row at a time as it renders\n" );
+	printf( "\t-headless     ray trace without opening a window, write the image and exit\n" );
+	printf( "\t-checkpoint <file>\n" );
+	printf( "\t              save the render's progress to file every so often\n" );
+	printf( "\t-resume       pick up the render saved in the checkpoint file\n" );
+	printf( "\t-seed <n>     seed the random numbers with n, so the render can be repeated\n" );
+	printf( "\t              exactly (and a resumed render matches an uninterrupted one)\n" );
+	printf( "\t-coordinator <port>\n" );
+	printf( "\t              don't trace anything; hand tiles out to workers connecting on port\n" );
+	printf( "\t-worker <host>:<port>\n" );
+	printf( "\t              render tiles for the coordinator at host:port until it's done\n" );
+	printf( "\t-crop <x> <y> <width> <height>\n" );
+	printf( "\t              only render this rectangle (in pixels from the top-left corner);\n" );
+	printf( "\t              the rest of the image is left as the background\n" );
+	printf( "\t-profile <file>\n" );
+	printf( "\t              write how long each phase took (and the ray counts) to file\n" );
+	printf( "\t              as JSON after every render\n" );
+	printf( "\t-perf-counters\n" );
+	printf( "\t              also count cycles, instructions, cache misses and branch misses\n" );
+	printf( "\t              for each phase (and in the benchmarks), where Linux's perf_event\n" );
+	printf( "\t              allows it\n" );
+	printf( "\t-trace <file>  write a timeline of the render (phases, tiles and rays per second)\n" );
+	printf( "\t              to file for chrome://tracing or ui.perfetto.dev after every render\n" );
+	printf( "\t-heatmap <prefix>\n" );
+	printf( "\t              write the time, BVH nodes, primitive tests and shadow rays each\n" );
+	printf( "\t              pixel took to <prefix>_<metric>.ppm (false colour) and .pfm (raw)\n" );
+	printf( "\t-benchmark <file>\n" );
+	printf( "\t              don't render; time BVH builds and fixed sets of rays on the meshes\n" );
+	printf( "\t              in Resource, write the results to file (.csv or JSON) and exit\n" );
+	printf( "\t-benchmark-shading <file>\n" );
+	printf( "\t              don't render; time each material shading synthetic hits (with and\n" );
+	printf( "\t              without geometry to trace against) and the noise functions, write\n" );
+	printf( "\t              the ns per evaluation to file (.csv or JSON) and exit\n" );
+	printf( "\t-regress <dir>  render the reference scenes small with a fixed seed, compare them\n" );
+	printf( "\t              with the images and rays/sec baselines in dir and exit (1 on failure).\n" );
+	printf( "\t              scenes without a reference get one\n" );
+	printf( "\t-regress-update\n" );
+	printf( "\t              save every render as its new reference and baseline\n" );
+	printf( "\t-regress-tolerance <percent>\n" );
+	printf( "\t              how much lower than the baseline rays/sec may be (default %d)\n", REGRESS_THROUGHPUT_TOLERANCE );
+	printf( "\t-bvh-analysis <file.obj>\n" );
+	printf( "\t              report the BVH's SAH cost, depths, leaf sizes, overlap and memory,\n" );
+	printf( "\t              write its boxes to file, and compare the SAH cost with the cost\n" );
+	printf( "\t              the render's rays paid\n" );
+}
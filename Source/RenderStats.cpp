@@ -0,0 +1,103 @@
+#include "RenderStats.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+
+THREAD_LOCAL RenderStats::Counters RenderStats::s_local;
+RenderStats::Counters RenderStats::s_total;
+SpinLock RenderStats::s_lock;
+
+void
+RenderStats::Counters::clear()
+{
+	memset( this, 0, sizeof(*this) );
+}
+
+void
+RenderStats::Counters::add( const Counters& other )
+{
+	for( int i = 0; i < NUM_RAY_TYPES; i++ )
+		rays[i] += other.rays[i];
+	boundingVolumeTests += other.boundingVolumeTests;
+	primitiveTests += other.primitiveTests;
+}
+
+RenderStats::Count
+RenderStats::Counters::totalRays() const
+{
+	Count total = 0;
+	for( int i = 0; i < NUM_RAY_TYPES; i++ )
+		total += rays[i];
+	return total;
+}
+
+void
+RenderStats::merge()
+{
+	add( s_local );
+	s_local.clear();
+}
+
+void
+RenderStats::add( const Counters& counters )
+{
+	s_lock.lock();
+	s_total.add( counters );
+	s_lock.unlock();
+}
+
+void
+RenderStats::reset()
+{
+	s_lock.lock();
+	s_total.clear();
+	s_lock.unlock();
+
+	s_local.clear();
+}
+
+RenderStats::Counters
+RenderStats::total()
+{
+	s_lock.lock();
+	const Counters total = s_total;
+	s_lock.unlock();
+
+	return total;
+}
+
+const char *
+RenderStats::rayTypeName( int type )
+{
+	static const char * names[NUM_RAY_TYPES] =
+	{
+		"camera", "depth of field", "shadow", "reflection", "refraction", "path", "photon"
+	};
+	return type >= 0 && type < NUM_RAY_TYPES ? names[type] : "unknown";
+}
+
+void
+RenderStats::print()
+{
+	if( !USE_RENDER_STATS )
+	{
+		printf( "\t(ray statistics are compiled out; see USE_RENDER_STATS)\n" );
+		return;
+	}
+
+	const Counters counters = total();
+	const Count numRays = counters.totalRays();
+	// don't divide by zero for a render that traced nothing
+	const double perRay = numRays > 0 ? 1.0 / (double)numRays : 0.0;
+
+	printf( "\t%llu rays\n", numRays );
+	for( int i = 0; i < NUM_RAY_TYPES; i++ )
+	{
+		if( counters.rays[i] > 0 )
+			printf( "\t\t%llu %s rays (%.1f%%)\n", counters.rays[i], rayTypeName( i ), counters.rays[i] * perRay * 100.0 );
+	}
+	printf( "\t%llu ray <=> bounding volume intersections\n", counters.boundingVolumeTests );
+	printf( "\t%llu ray <=> primitive intersections\n", counters.primitiveTests );
+	printf( "\t%.4f average triangle intersections per ray\n", counters.primitiveTests * perRay );
+	printf( "\t%.4f average bounding volume intersections per ray\n", counters.boundingVolumeTests * perRay );
+}
@@ -9,25 +9,57 @@
 #include "AreaLight.h"
 #include "SpecularReflector.h"
 #include "SpecularRefractor.h"
-
+#include "ImageWriter.h"
+#include "RenderOptions.h"
+#include "RenderCheckpoint.h"
+#include "DistributedRenderer.h"
+#include "ProgressReporter.h"
+#include "Timer.h"
+#include "Profiler.h"
+#include "MemoryStats.h"
+#include "TraceRecorder.h"
+#include "BVHAnalysis.h"
+
+#ifdef WIN32
 #include <windows.h>
+#endif
 #include <time.h>
 #include <stdlib.h>
 
 Scene * g_scene = 0;
 
-Scene::Scene() : m_environment_map(0), m_map_width(0), m_map_height(0), m_photon_map(0)
+Scene::Scene() : m_environment_map(0), m_map_width(0), m_map_height(0), m_photon_map(0), m_last_checkpoint(0),
+	m_crop_x(0), m_crop_y(0), m_crop_width(0), m_crop_height(0)
 {
-	m_num_rays_traced = 0;
 }
 
 Scene::~Scene()
 {
-	m_bvh.~BVH();
-	
-	// objects are deleted by the bvh destructor
+	// the bvh only references the objects and meshes, so they're deleted here
+	for( unsigned int i = 0; i < m_objects.size(); i++ )
+	{
+		if( m_objects[i] )
+		{
+			delete m_objects[i];
+			m_objects[i] = NULL;
+		}
+	}
 	m_objects.clear();
 
+	for( unsigned int i = 0; i < m_meshes.size(); i++ )
+	{
+		if( m_meshes[i] )
+		{
+			delete m_meshes[i];
+			m_meshes[i] = NULL;
+		}
+	}
+	m_meshes.clear();
+
+	for( unsigned int i = 0; i < m_instanced_meshes.size(); i++ )
+		delete m_instanced_meshes[i];
+	m_instanced_meshes.clear();
+
 	for( unsigned int i = 0; i < m_lights.size(); i++ )
 	{
 		if( m_lights[i] )
@@ -43,6 +75,13 @@ Scene::~Scene()
 		delete m_photon_map;
 		m_photon_map = NULL;
 	}
+
+	if( m_environment_map )
+	{
+		delete [] m_environment_map;
+		m_environment_map = NULL;
+		MemoryStats::remove( MemoryStats::ENVIRONMENT_MAP, m_map_width * m_map_height * sizeof(Vector3) );
+	}
 }
 
 void
@@ -59,6 +98,8 @@ Scene::openGL(Camera *cam)
 	{
 		for (size_t i = 0; i < m_objects.size(); ++i)
 			m_objects[i]->renderGL();
+		for (size_t i = 0; i < m_meshes.size(); ++i)
+			m_meshes[i]->renderGL();
 	}
 	
 
@@ -72,6 +113,8 @@ Scene::preCalc()
 	if( USE_ENVIRONMENT_MAP )
 	{
 		m_environment_map = PFMLoader::readPFMImage( ENVIRONMENT_MAP_FILE_NAME, &m_map_width, &m_map_height );
+		if( m_environment_map )
+			MemoryStats::add( MemoryStats::ENVIRONMENT_MAP, m_map_width * m_map_height * sizeof(Vector3) );
 	}
 
     Objects::iterator it;
@@ -87,17 +130,13 @@ Scene::preCalc()
         pLight->preCalc();
     }
 
-    m_bvh.build(&m_objects);
+    m_bvh.build(&m_objects, &m_meshes);
 }
 
 void
 Scene::raytraceImage(Camera *cam, Image *img)
 {
-    Ray ray;
-    HitInfo hitInfo;
-    Vector3 shadeResult;
-
-	BVH::resetIntersections();
+	RenderStats::reset();
 
 	/*
 	SYSTEMTIME locStartTime;
@@ -108,14 +147,158 @@ Scene::raytraceImage(Camera *cam, Image *img)
 		locStartTime.wSecond, locStartTime.wMilliseconds );
 	*/   
 
+	// pick up where a checkpointed render left off, or start a new one
+	bool resumed = false;
+	if( g_options.resume )
+	{
+		resumed = m_checkpoint.load( g_options.checkpointFile, *img, &m_accumulation );
+		if( resumed && m_checkpoint.mode != renderMode() )
+		{
+			printf( "Checkpoint %s was made with a different render mode; starting over\n", g_options.checkpointFile );
+			img->clear( cam->bgColor() );
+			resumed = false;
+		}
+		if( resumed )
+			printf( "Resuming render from %s at pass %d, row %d\n", g_options.checkpointFile, m_checkpoint.pass, m_checkpoint.row );
+	}
+	if( !resumed )
+	{
+		m_checkpoint = RenderCheckpoint();
+		m_checkpoint.mode = renderMode();
+		m_checkpoint.seed = g_options.fixedSeed ? g_options.seed : (unsigned)time(0);
+		m_checkpoint.width = img->width();
+		m_checkpoint.height = img->height();
+	}
+
+	// checkpoints save the HDR sums and sample counts
+	if( g_options.checkpointFile )
+		img->setHDR(true);
+
+	// a crop window starts over, while the rest of the image keeps what it had
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+	if( hasCropWindow() )
+	{
+		printf( "Rendering the %d x %d crop window at (%d, %d)\n", x1 - x0, y1 - y0, m_crop_x, m_crop_y );
+		img->clear(cam->bgColor(), x0, y0, x1, y1);
+	}
+
+	// a resumed render reuses the photon map saved with the checkpoint
+	if( USE_PHOTON_MAPPING && !m_photon_map && resumed && !m_checkpoint.photonMapFile.empty() )
+	{
+		m_photon_map = PhotonMap::load( m_checkpoint.photonMapFile.c_str() );
+		if( !m_photon_map )
+			m_checkpoint.photonMapFile.clear();
+	}
+
+	// the coordinator doesn't trace anything itself, so it has no use for a photon map
+	if( !g_options.coordinatorPort )
+		setupRender(m_checkpoint.seed);
+
+	// checkpoints refer to a saved copy of the photon map rather than containing it
+	if( g_options.checkpointFile && m_photon_map && m_checkpoint.photonMapFile.empty() )
+	{
+		const std::string photonMapFile = std::string( g_options.checkpointFile ) + ".photons";
+		if( m_photon_map->save( photonMapFile.c_str() ) )
+			m_checkpoint.photonMapFile = photonMapFile;
+	}
+
+	// -heatmap measures every pixel rendered from here on (a resumed render's
+	// earlier pixels cost nothing, as far as it knows)
+	if( g_options.heatmapPrefix )
+		m_cost_map.resize(img->width(), img->height());
+
+	// count the time spent before a resumed checkpoint too, so time limits carry over
+	const double startTime = Timer::now() - m_checkpoint.elapsedSeconds;
+	m_last_checkpoint = Timer::now();
+
+	if( g_options.coordinatorPort )
+	{
+		// the workers send back the tiles (and the rays they took)
+		DistributedRenderer::coordinate(g_options.coordinatorPort, m_checkpoint.seed, img, this);
+		writeOutput(img);
+	}
+	else if( USE_PROGRESSIVE_RENDERING )
+		renderProgressive(cam, img, startTime);
+	else if( USE_ADAPTIVE_SAMPLING )
+	{
+		renderAdaptive(cam, img, startTime);
+		writeOutput(img);
+	}
+	else
+		renderTiles(cam, img, startTime);
+
+	/*
+	SYSTEMTIME locEndTime;
+
+	GetLocalTime(&locEndTime);
+	*/
+	const double endTime = Timer::now();
+	RenderStats::merge();
+	Profiler::merge();
+    
+    printf("Rendering Progress: 100.000%\n");
+    debug("done Raytracing!\n");
+	/*
+	printf( "Rendering end time: %02d:%02d:%02d:%02d\n", locEndTime.wHour, locEndTime.wMinute, 
+		locEndTime.wSecond, locEndTime.wMilliseconds );
+	*/
+
+	printf("Rendering statistics:\n");	
+	printf("\tTotal render time: %.4f seconds\n", endTime - startTime);
+	printf("\t%d BVH nodes (includes # leaves)\n", m_bvh.numNodes() );
+	printf("\t\t(up to %d child(ren) per node)\n", NUM_NODE_CHILDREN );
+	printf("\t%d BVH leaves\n", m_bvh.numLeaves() );
+	printf("\t\t(up to %d primitive(s) per leaf)\n", NUM_LEAF_CHILDREN );
+	RenderStats::print();
+	if( g_options.bvhAnalysisFile )
+	{
+		// the estimate is for rays that hit the root's box, and counts only the top level hierarchy
+		printf("\t%.3f measured traversal cost per ray (SAH estimate %.3f)\n",
+			BVHAnalysis::measuredCost(RenderStats::total()), m_bvh.sahCost());
+	}
+	Profiler::print();
+	printf("Memory:\n");
+	MemoryStats::print();
+	printf("\n");
+
+	// everything since the last report (the scene load too, the first time)
+	if( g_options.profileFile && Profiler::writeJSON(g_options.profileFile, img->width(), img->height(), m_checkpoint.seed, endTime - startTime) )
+		printf("Wrote the profile to %s\n", g_options.profileFile);
+	Profiler::reset();
+	if( g_options.traceFile )
+		TraceRecorder::write(g_options.traceFile);
+	if( !m_cost_map.isEmpty() )
+	{
+		m_cost_map.write(g_options.heatmapPrefix);
+		m_cost_map.resize(0, 0);
+	}
+}
+
+void
+Scene::setupRender(unsigned int seed)
+{
+	m_checkpoint.seed = seed;
+
 	// seed randomizer for photon mapping, bump mapping, path tracing and/or depth of field 
-	// (always seed it just in case we're doing bump mapping)
-	srand((unsigned)time(0));
+	// (always seed it just in case we're doing bump mapping). rendering reseeds every row or tile
+	srand(seed);
+	m_sample_random.setSeed(seed);
 
 	// create the photon map first (don't do this if we've already done it once!)
 	if( USE_PHOTON_MAPPING && !m_photon_map )
+		buildPhotonMap();
+}
+
+void
+Scene::buildPhotonMap()
+{
+    Ray ray;
+    HitInfo hitInfo;
+
+	printf( "Beginning photon mapping calculations...\n" );
 	{
-		printf( "Beginning photon mapping calculations...\n" );
+		PROFILE_SCOPE(PHOTON_EMISSION);
 
 		// divide total number of photons up evenly amongst all lights in the scene
 		const Lights *lightlist = this->lights();
@@ -124,7 +307,7 @@ Scene::raytraceImage(Camera *cam, Image *img)
 		// just in case the number of photons wasn't evenly divisible by the number of lights
 		int totalNumPhotons = numPhotonsPerLight * lightlist->size();
 		m_photon_map = new PhotonMap( totalNumPhotons );
-	    
+    
 		// loop over all of the lights
 		Lights::const_iterator lightIter;
 		for (lightIter = lightlist->begin(); lightIter != lightlist->end(); lightIter++)
@@ -166,7 +349,7 @@ Scene::raytraceImage(Camera *cam, Image *img)
 				int numBounces = 0;
 				int specularRecursionCount = 0;
 				// the photon hit something!
-				while( keepTracing && trace( hitInfo, ray, traceMinDistance ) )
+				while( keepTracing && trace( hitInfo, ray, RenderStats::PHOTON, traceMinDistance ) )
 				{
 					// if this wasn't a diffuse material, we need to reflect/refract appropriately and keep tracing
 					if( !hitInfo.material->isDiffuse() )
@@ -271,115 +454,507 @@ Scene::raytraceImage(Camera *cam, Image *img)
 				}
 			}
 		}
+	}
 
-		// now that we're done creating the photon map, balance the kd tree
+	// now that we're done creating the photon map, balance the kd tree
+	{
+		PROFILE_SCOPE(PHOTON_BALANCE);
 		m_photon_map->balance();
+	}
+
+	printf( "Done with photon map calculations!\n\n" );
+}
+
+bool
+Scene::setCropWindow(int x, int y, int width, int height, const Image *img)
+{
+	m_crop_x = m_crop_y = m_crop_width = m_crop_height = 0;
+	if( width <= 0 || height <= 0 )
+		return true;
+
+	if( x < 0 || y < 0 || x >= img->width() || y >= img->height() )
+	{
+		fprintf( stderr, "The crop window at (%d, %d) is outside the %d x %d image\n", x, y, img->width(), img->height() );
+		return false;
+	}
+
+	// whatever hangs off the image's edges is cut off
+	m_crop_x = x;
+	m_crop_y = y;
+	m_crop_width = std::min(width, img->width() - x);
+	m_crop_height = std::min(height, img->height() - y);
+	return true;
+}
+
+void
+Scene::renderWindow(const Image *img, int& x0, int& y0, int& x1, int& y1) const
+{
+	x0 = 0;
+	y0 = 0;
+	x1 = img->width();
+	y1 = img->height();
+	if( !hasCropWindow() )
+		return;
+
+	// the image's rows go from the bottom up, the crop window's from the top down
+	x0 = std::min(m_crop_x, img->width());
+	x1 = std::min(m_crop_x + m_crop_width, img->width());
+	y0 = std::max(img->height() - m_crop_y - m_crop_height, 0);
+	y1 = std::max(img->height() - m_crop_y, 0);
+}
+
+int
+Scene::tilePixelsInWindow(const Image *img, int tileX, int tileY, int tileWidth, int tileHeight) const
+{
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+	const int width = std::min(tileX + tileWidth, x1) - std::max(tileX, x0);
+	const int height = std::min(tileY + tileHeight, y1) - std::max(tileY, y0);
+	return width > 0 && height > 0 ? width * height : 0;
+}
 
-		printf( "Done with photon map calculations!\n\n" );
-	} // end if( USE_PHOTON_MAPPING )
+void
+Scene::renderTile(Camera *cam, Image *img, int tileX, int tileY, int tileWidth, int tileHeight)
+{
+	// eye rays for a whole tile are generated at once into this buffer
+	Ray tileRays[TILE_SIZE * TILE_SIZE];
+
+	const double tileStart = Timer::now();
+	PROFILE_PER_PIXEL_COUNTERS();
+
+	// each tile has its own random numbers, so it renders the same no matter
+	// which order (or process) the tiles are rendered in
+	reseed(0, tileX, tileY);
+
+	cam->eyeRays(tileRays, tileX, tileY, tileWidth, tileHeight, img->width(), img->height());
+
+	// a tile on the edge of a crop window still shades the pixels outside it, so the
+	// random numbers run just as they do in a full render, but leaves them alone
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+
+	for (int j = 0; j < tileHeight; ++j)
+	{
+		for (int i = 0; i < tileWidth; ++i)
+		{
+			const bool inWindow = tileX + i >= x0 && tileX + i < x1 && tileY + j >= y0 && tileY + j < y1;
+			const CostMap::Snapshot cost = m_cost_map.isEmpty() ? CostMap::Snapshot() : CostMap::snapshot();
+			Vector3 shadeResult = shadePixel(cam, tileRays[j * tileWidth + i]);
+			if( !inWindow )
+				continue;
+			if( !m_cost_map.isEmpty() )
+				m_cost_map.add(tileX + i, tileY + j, cost);
 
-	clock_t clockStart = clock();
+			// now actually set the pixel color
+			img->setPixel(tileX + i, tileY + j, shadeResult);
+		}
+	}
+
+	TraceRecorder::span("tile", "render", tileStart, Timer::now(), "x", tileX, "y", tileY);
+}
+
+void
+Scene::renderTiles(Camera *cam, Image *img, double startTime)
+{
 
-	g_scene->m_num_rays_traced = 0;
-    // loop over all pixels in the image
-    for (int j = 0; j < img->height(); ++j)
+	// rows go to disk as soon as their row of tiles is done
+	ImageWriter * writer = g_options.outputFile ? ImageWriter::create(g_options.outputFile) : 0;
+	if( writer && !writer->open(g_options.outputFile, img->width(), img->height()) )
+	{
+		delete writer;
+		writer = 0;
+	}
+
+	// the part of the image to render, and the first tile that touches it. tiles stay on
+	// the TILE_SIZE grid a full render uses, so each one is seeded the same
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+	const int firstTileX = x0 - x0 % TILE_SIZE;
+
+	// rows restored from a checkpoint (or below the crop window) are already done,
+	// and don't count towards the time estimate
+	const int startRow = std::max(m_checkpoint.row, y0 - y0 % TILE_SIZE);
+	for (int j = 0; writer && j < startRow; ++j)
+		writer->writeScanline(*img, j);
+
+	// progress is counted in pixels of the window, a tile at a time
+	ProgressReporter progress("Progress", (x1 - x0) * (y1 - y0), (x1 - x0) * std::max(startRow - y0, 0), startTime);
+	TraceRate rayRate("rays/s", (double)RenderStats::local().totalRays());
+
+    // loop over the image one row of tiles at a time
+    for (int tileY = startRow; tileY < y1; tileY += TILE_SIZE)
     {
-        for (int i = 0; i < img->width(); ++i)
-        {		
-			ray = cam->eyeRay(i, j, img->width(), img->height());
-			if (trace(hitInfo, ray))
+		const int tileHeight = std::min(TILE_SIZE, img->height() - tileY);
+
+        for (int tileX = firstTileX; tileX < x1; tileX += TILE_SIZE)
+        {
+			const int tileWidth = std::min(TILE_SIZE, img->width() - tileX);
+
+			renderTile(cam, img, tileX, tileY, tileWidth, tileHeight);
+			progress.update(tilePixelsInWindow(img, tileX, tileY, tileWidth, tileHeight));
+			rayRate.update((double)RenderStats::local().totalRays());
+		}
+
+		int numRowsDone = tileY + tileHeight;
+
+		displayRows(img, tileY, numRowsDone);
+		for (int j = tileY; writer && j < numRowsDone; ++j)
+			writer->writeScanline(*img, j);
+		saveCheckpoint(img, 0, numRowsDone, startTime, numRowsDone == img->height());
+    }
+
+	progress.done();
+
+	// and the rows above the crop window
+	for (int j = std::max(startRow, y1); writer && j < img->height(); ++j)
+		writer->writeScanline(*img, j);
+
+	if( writer )
+	{
+		writer->close();
+		delete writer;
+	}
+}
+
+void
+Scene::renderAdaptive(Camera *cam, Image *img, double startTime)
+{
+	const int width = img->width();
+	const int height = img->height();
+
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+	const int numPixels = (x1 - x0) * (y1 - y0);
+
+	// a resumed render already has its statistics from the checkpoint
+	if( m_checkpoint.pass == 0 )
+		m_accumulation.resize(width, height);
+
+	int numActive = numPixels;
+	bool outOfTime = false;
+	int pass;
+	TraceRate rayRate("rays/s", (double)RenderStats::local().totalRays());
+
+	for( pass = m_checkpoint.pass; numActive > 0 && !outOfTime; pass++ )
+	{
+		const double passStart = Timer::now();
+		numActive = 0;
+		int numPassSamples = 0;
+
+		for( int y = y0; y < y1 && !outOfTime; y++ )
+		{
+			PROFILE_PER_PIXEL_COUNTERS();
+			reseed(pass, 0, y);
+
+			for( int x = x0; x < x1; x++ )
 			{
-				if( USE_DEPTH_OF_FIELD )
+				if( m_accumulation.isConverged(x, y) )
+					continue;
+
+				const int numSamples = m_accumulation.numSamples(x, y);
+				int numNewSamples;
+
+				if( numSamples < ADAPTIVE_MIN_SAMPLES )
 				{
-					Vector3 focalPlanePt;
-					Ray depthOfFieldRay;
-					HitInfo depthOfFieldHitInfo;
-					Vector3 depthOfFieldShadeResult(0,0,0);
-					for( int k = 0; k < NUM_DEPTH_OF_FIELD_SAMPLES; k++ )
+					// not enough samples yet to trust the variance estimate
+					numNewSamples = ADAPTIVE_MIN_SAMPLES - numSamples;
+				}
+				else
+				{
+					const float error = m_accumulation.relativeError(x, y, ADAPTIVE_ERROR_FLOOR);
+					if( error <= ADAPTIVE_ERROR_THRESHOLD )
 					{
-						bool foundPt = cam->getFocalPlaneIntersection( focalPlanePt, hitInfo.P );
-						// if we didn't find the focal plane point, do nothing
-						if( foundPt )
-						{
-							depthOfFieldRay.o = cam->getRandomApertureSample();
-							depthOfFieldRay.d = focalPlanePt - depthOfFieldRay.o;
-							depthOfFieldRay.d.normalize();
-							
-							if( trace( depthOfFieldHitInfo, depthOfFieldRay ) )
-							{
-								depthOfFieldShadeResult += depthOfFieldHitInfo.material->shade( depthOfFieldRay, depthOfFieldHitInfo, *this );
-							}
-						}
+						m_accumulation.setConverged(x, y);
+						continue;
 					}
 
-					shadeResult = depthOfFieldShadeResult / NUM_DEPTH_OF_FIELD_SAMPLES;
-				} // end if( USE_DEPTH_OF_FIELD )
-				// don't use depth of field
+					// the error falls off as 1/sqrt(n), so this many samples in total should
+					// bring it under the threshold. noisier pixels get more of this pass's budget
+					const float ratio = error / ADAPTIVE_ERROR_THRESHOLD;
+					const float numNeeded = std::min( (float)ADAPTIVE_MAX_SAMPLES, numSamples * ratio * ratio );
+					numNewSamples = std::max( 1, std::min( ADAPTIVE_SAMPLES_PER_PASS, (int)ceil( numNeeded ) - numSamples ) );
+				}
+
+				numNewSamples = std::min( numNewSamples, ADAPTIVE_MAX_SAMPLES - numSamples );
+				const CostMap::Snapshot cost = m_cost_map.isEmpty() ? CostMap::Snapshot() : CostMap::snapshot();
+				for( int k = 0; k < numNewSamples; k++ )
+					m_accumulation.addSample(x, y, shadeSample(cam, x, y, width, height));
+				if( !m_cost_map.isEmpty() )
+					m_cost_map.add(x, y, cost);
+				numPassSamples += numNewSamples;
+
+				if( numSamples + numNewSamples >= ADAPTIVE_MAX_SAMPLES )
+					m_accumulation.setConverged(x, y);
 				else
-				{
-					shadeResult = hitInfo.material->shade(ray, hitInfo, *this);
-				} // end don't use depth of field
+					numActive++;
+
+				img->setPixel(x, y, m_accumulation.mean(x, y));
 			}
-			else
+
+			displayRows(img, y, y + 1);
+			rayRate.update((double)RenderStats::local().totalRays());
+
+			// every pixel needs its first samples, so the time limit only kicks in after the first pass
+			if( pass > 0 && ADAPTIVE_TIME_LIMIT > 0 && Timer::now() - startTime >= ADAPTIVE_TIME_LIMIT )
+				outOfTime = true;
+		}
+
+		TraceRecorder::span("pass", "render", passStart, Timer::now(), "pass", pass, "active pixels", numActive);
+
+		printf("\rPass %d: %d samples, %d of %d pixels still noisy, Time elapsed: %.4f sec          \r",
+			pass, numPassSamples, numActive, numPixels, Timer::now() - startTime);
+		fflush(stdout);
+
+		saveCheckpoint(img, pass + 1, 0, startTime, numActive == 0 || outOfTime);
+	}
+
+	if( outOfTime )
+		printf("\nAdaptive sampling stopped by the %.1f second time limit\n", (float)ADAPTIVE_TIME_LIMIT);
+	else
+		printf("\n");
+}
+
+void
+Scene::renderProgressive(Camera *cam, Image *img, double startTime)
+{
+	const int width = img->width();
+	const int height = img->height();
+
+	int x0, y0, x1, y1;
+	renderWindow(img, x0, y0, x1, y1);
+
+	// the passes are averaged in the image's float buffer
+	img->setHDR(true);
+
+	// progress is counted in samples, a row at a time (without a sample target there's no end to estimate)
+	const int numPixels = (x1 - x0) * (y1 - y0);
+	ProgressReporter progress("Progress", std::max(PROGRESSIVE_SAMPLE_TARGET, 0) * numPixels, m_checkpoint.pass * numPixels, startTime);
+	TraceRate rayRate("rays/s", (double)RenderStats::local().totalRays());
+
+	bool outOfTime = false;
+	int pass;
+	for( pass = m_checkpoint.pass; !outOfTime && ( PROGRESSIVE_SAMPLE_TARGET <= 0 || pass < PROGRESSIVE_SAMPLE_TARGET ); pass++ )
+	{
+		const double passStart = Timer::now();
+
+		for( int y = y0; y < y1; y++ )
+		{
+			PROFILE_PER_PIXEL_COUNTERS();
+			reseed(pass, 0, y);
+
+			for( int x = x0; x < x1; x++ )
 			{
-				if( USE_ENVIRONMENT_MAP && this->environmentMap() )
-				{
-					shadeResult = EnvironmentMap::lookUp( ray.d, this->environmentMap(), this->mapWidth(), this->mapHeight() );
-				}
+				const CostMap::Snapshot cost = m_cost_map.isEmpty() ? CostMap::Snapshot() : CostMap::snapshot();
+				img->addSample(x, y, shadeSample(cam, x, y, width, height));
+				if( !m_cost_map.isEmpty() )
+					m_cost_map.add(x, y, cost);
 			}
+			progress.update(x1 - x0);
+			rayRate.update((double)RenderStats::local().totalRays());
 
-			// now actually set the pixel color
-			img->setPixel(i, j, shadeResult);
+			// the first pass always finishes so every pixel has a sample. after that a pass can be
+			// cut short; the rows it didn't reach just have one sample fewer
+			if( pass > 0 && PROGRESSIVE_TIME_BUDGET > 0 && Timer::now() - startTime >= PROGRESSIVE_TIME_BUDGET )
+			{
+				outOfTime = true;
+				break;
+			}
 		}
 
-		clock_t rowEndTime = clock();
+		TraceRecorder::span("pass", "render", passStart, Timer::now(), "pass", pass);
 
-		float timeSoFar = rowEndTime - clockStart;
-		int numRowsDone = j + 1;
-		int numRowsLeft = img->height() - numRowsDone + 1;
-		float avgSecondsPerRow = ( timeSoFar/CLOCKS_PER_SEC ) / numRowsDone;
+		// refresh the display (and output file) with this pass's average
+		displayRows(img, y0, y1);
+		writeOutput(img);
 
-        img->drawScanline(j);
-        glFinish();
-		//printf("Rendering Progress: %.3f%%\r", j/float(img->height())*100.0f);
-        printf("\rProgress: %.3f%%, Time elapsed: %.4f sec, Est. time left: %.4f sec\r", 
-			j/float(img->height())*100.0f, timeSoFar/CLOCKS_PER_SEC, numRowsLeft * (timeSoFar/CLOCKS_PER_SEC) / numRowsDone);
-		
-        fflush(stdout);
-    }
+		if( PROGRESSIVE_TIME_BUDGET > 0 && Timer::now() - startTime >= PROGRESSIVE_TIME_BUDGET )
+			outOfTime = true;
 
-	/*
-	SYSTEMTIME locEndTime;
+		printf("\rPass %d: %d samples per pixel, Time elapsed: %.4f sec          \r",
+			pass, pass + 1, Timer::now() - startTime);
+		fflush(stdout);
 
-	GetLocalTime(&locEndTime);
-	*/
-	clock_t clockEnd = clock();
-    
-    printf("Rendering Progress: 100.000%\n");
-    debug("done Raytracing!\n");
-	/*
-	printf( "Rendering end time: %02d:%02d:%02d:%02d\n", locEndTime.wHour, locEndTime.wMinute, 
-		locEndTime.wSecond, locEndTime.wMilliseconds );
-	*/
+		saveCheckpoint(img, pass + 1, 0, startTime, outOfTime || pass + 1 == PROGRESSIVE_SAMPLE_TARGET);
+	}
 
-	printf("Rendering statistics:\n");	
-	printf("\tTotal render time: %.4f seconds\n", ((float)(clockEnd - clockStart))/CLOCKS_PER_SEC);
-	printf("\t%d BVH nodes (includes # leaves)\n", m_bvh.numNodes() );
-	printf("\t\t(up to %d child(ren) per node)\n", NUM_NODE_CHILDREN );
-	printf("\t%d BVH leaves\n", m_bvh.numLeaves() );
-	printf("\t\t(up to %d primitive(s) per leaf)\n", NUM_LEAF_CHILDREN );
-	printf("\t%d rays\n", g_scene->m_num_rays_traced);
-	printf("\t%d ray <=> bounding volume intersections\n", BVH::BoundingVolumeIntersections());
-	printf("\t%d ray <=> primitive intersections\n", BVH::PrimitiveIntersections());
-	printf("\t%.4f average triangle intersections per ray\n", BVH::PrimitiveIntersections()/(float)g_scene->m_num_rays_traced);
-	printf("\t%.4f average bounding volume intersections per ray\n", BVH::BoundingVolumeIntersections()/(float)g_scene->m_num_rays_traced);
-	printf("\n");
+	if( outOfTime )
+		printf("\nProgressive rendering stopped by the %.1f second time budget after %d pass(es)\n", (float)PROGRESSIVE_TIME_BUDGET, pass);
+	else
+		printf("\n");
+}
+
+int
+Scene::renderMode()
+{
+	if( USE_PROGRESSIVE_RENDERING )
+		return RenderCheckpoint::PROGRESSIVE;
+	if( USE_ADAPTIVE_SAMPLING )
+		return RenderCheckpoint::ADAPTIVE;
+	return RenderCheckpoint::TILES;
+}
+
+void
+Scene::reseed(int pass, int x, int y)
+{
+	// hash the seed with the position, so each row's (or tile's) random numbers depend only on where
+	// it is and not on how many were used before it, whether the render was resumed or which process ran it
+	unsigned int h = m_checkpoint.seed ^ ( (unsigned int)pass * 0x9e3779b9u ) ^ ( (unsigned int)x * 0xc2b2ae35u ) ^ ( (unsigned int)y * 0x85ebca6bu );
+	h ^= h >> 16;
+	h *= 0x7feb352du;
+	h ^= h >> 15;
+	h *= 0x846ca68bu;
+	h ^= h >> 16;
+
+	srand(h);
+	m_sample_random.setSeed(h);
+}
+
+void
+Scene::saveCheckpoint(Image *img, int pass, int row, double startTime, bool force)
+{
+	// a checkpoint can't describe a render of part of the image
+	if( !g_options.checkpointFile || hasCropWindow() )
+		return;
+	if( !force && Timer::now() - m_last_checkpoint < CHECKPOINT_INTERVAL )
+		return;
+
+	m_checkpoint.pass = pass;
+	m_checkpoint.row = row;
+	m_checkpoint.elapsedSeconds = Timer::now() - startTime;
+	m_checkpoint.save(g_options.checkpointFile, *img, &m_accumulation);
+
+	m_last_checkpoint = Timer::now();
+}
+
+void
+Scene::displayRows(Image *img, int y0, int y1)
+{
+	if( g_options.headless )
+		return;
+
+	for( int y = y0; y < y1; y++ )
+		img->drawScanline(y);
+
+	// glFinish() would wait for the drawing to be done; the render doesn't need to
+	glFlush();
+}
+
+void
+Scene::writeOutput(Image *img)
+{
+	if( !g_options.outputFile )
+		return;
+
+	ImageWriter * writer = ImageWriter::create(g_options.outputFile);
+	if( writer && writer->open(g_options.outputFile, img->width(), img->height()) )
+		writer->writeImage(*img);
+	delete writer;
+}
+
+Vector3
+Scene::shadePixel(Camera *cam, const Ray& ray)
+{
+	if( !USE_DEPTH_OF_FIELD )
+		return shadeRay(ray, RenderStats::CAMERA);
+
+	// the first lens sample goes anywhere on the lens. where it hits decides how blurry
+	// this pixel is, and so how many lens samples it needs; it's then the sample for
+	// whichever stratum it landed in, so nothing is traced just to measure the blur
+	const float firstU = m_sample_random.nextFloat();
+	const float firstV = m_sample_random.nextFloat();
+	const Ray firstRay = cam->lensRay( ray, firstU, firstV );
+
+	HitInfo hitInfo;
+	bool hit;
+	{
+		PROFILE_SCOPE(PRIMARY_TRACING);
+		hit = trace(hitInfo, firstRay, RenderStats::DEPTH_OF_FIELD);
+	}
+
+	static const int maxStrata = (int)sqrt( (float)NUM_DEPTH_OF_FIELD_SAMPLES );
+
+	// a miss is background at infinity, which is as blurry as it gets
+	const float coc = hit ? cam->circleOfConfusion( hitInfo.P ) : cam->maxCircleOfConfusion();
+
+	// roughly one sample per pixel the blur covers; in focus pixels just keep the first one
+	const int numStrata = std::min( maxStrata, std::max( 1, (int)ceil( coc ) ) );
+
+	Vector3 shadeResult;
+	{
+		PROFILE_SCOPE(SHADING);
+		shadeResult = hit ? hitInfo.material->shade(firstRay, hitInfo, *this) : shadeMiss(firstRay);
+	}
+
+	if( numStrata == 1 )
+		return shadeResult;
+
+	// thin lens depth of field: jittered samples on a numStrata x numStrata grid over the lens,
+	// but for the stratum the first sample is already in
+	const int firstSx = std::min( (int)( firstU * numStrata ), numStrata - 1 );
+	const int firstSy = std::min( (int)( firstV * numStrata ), numStrata - 1 );
+	for( int sy = 0; sy < numStrata; sy++ )
+	{
+		for( int sx = 0; sx < numStrata; sx++ )
+		{
+			if( sx == firstSx && sy == firstSy )
+				continue;
+
+			const float lensU = ( sx + m_sample_random.nextFloat() ) / numStrata;
+			const float lensV = ( sy + m_sample_random.nextFloat() ) / numStrata;
+
+			shadeResult += shadeRay( cam->lensRay( ray, lensU, lensV ), RenderStats::DEPTH_OF_FIELD );
+		}
+	}
+
+	shadeResult /= (float)( numStrata * numStrata );
+
+	return shadeResult;
+}
+
+Vector3
+Scene::shadeSample(Camera *cam, int x, int y, int imageWidth, int imageHeight)
+{
+	// jitter within the pixel, and across the lens as well with depth of field
+	Ray ray = cam->eyeRay(x, y, m_sample_random.nextFloat(), m_sample_random.nextFloat(), imageWidth, imageHeight);
+	if( USE_DEPTH_OF_FIELD )
+	{
+		ray = cam->lensRay(ray, m_sample_random.nextFloat(), m_sample_random.nextFloat());
+		return shadeRay(ray, RenderStats::DEPTH_OF_FIELD);
+	}
+
+	return shadeRay(ray, RenderStats::CAMERA);
+}
+
+Vector3
+Scene::shadeRay(const Ray& ray, RenderStats::RayType type)
+{
+	HitInfo hitInfo;
+	bool hit;
+	{
+		PROFILE_SCOPE(PRIMARY_TRACING);
+		hit = trace(hitInfo, ray, type);
+	}
+
+	PROFILE_SCOPE(SHADING);
+	if( hit )
+		return hitInfo.material->shade(ray, hitInfo, *this);
+
+	return shadeMiss(ray);
+}
+
+Vector3
+Scene::shadeMiss(const Ray& ray) const
+{
+	if( USE_ENVIRONMENT_MAP && this->environmentMap() )
+		return EnvironmentMap::lookUp( ray.d, this->environmentMap(), this->mapWidth(), this->mapHeight() );
+
+	return Vector3(0.0f, 0.0f, 0.0f);
 }
 
 bool
-Scene::trace(HitInfo& minHit, const Ray& ray, float tMin, float tMax) const
+Scene::trace(HitInfo& minHit, const Ray& ray, RenderStats::RayType type, float tMin, float tMax) const
 {
-	g_scene->m_num_rays_traced++; // one more ray has been traced
+	RenderStats::countRay(type); // one more ray has been traced
     return m_bvh.intersect(minHit, ray, tMin, tMax);
 }
 
@@ -0,0 +1,262 @@
+#include "ShadingBenchmark.h"
+#include "BenchmarkUtil.h"
+#include "Scene.h"
+#include "TriangleMesh.h"
+#include "Ray.h"
+#include "Random.h"
+#include "RenderStats.h"
+#include "Lambert.h"
+#include "Stone.h"
+#include "Sand.h"
+#include "SpecularReflector.h"
+#include "SpecularRefractor.h"
+#include "PerlinNoise.h"
+#include "CustomizablePerlinNoise.h"
+#include "WorleyNoise.h"
+#include "DebugMem.h"
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+
+namespace
+{
+
+// slashes work on Windows too
+const char * MESH_FILE = "Resource/teapot.obj";
+
+struct Result
+{
+	const char * name;
+	const char * tracing;   // "stub" or "real" for materials, "-" for noise
+	int numEvaluations;
+	BenchmarkTiming timing; // the fastest of the runs
+	double raysPerEvaluation;
+};
+
+// a shading point and the ray that found it
+struct ShadingPoint
+{
+	Ray ray;
+	HitInfo hit;
+};
+
+// keeps the compiler from optimizing away work whose result is never used
+volatile float g_sink;
+
+// a scene lit by one point light above the given bounds, with the mesh in it if there is one
+Scene *
+makeScene( const Vector3 & min, const Vector3 & max, TriangleMesh * mesh, const Material * material )
+{
+	Scene * scene = new Scene;
+
+	PointLight * light = new PointLight;
+	light->setPosition( ( min + max ) * 0.5f + Vector3( 0.0f, 2.0f * ( max.y - min.y ), 0.0f ) );
+	light->setColor( Vector3( 1.0f ) );
+	light->setWattage( 700.0f );
+	scene->addLight( light );
+
+	if( mesh )
+	{
+		mesh->setMaterial( material );
+		scene->addMesh( mesh );
+	}
+
+	scene->preCalc();
+	// builds the photon map, which Lambert shading looks things up in
+	scene->setupRender( SHADING_BENCHMARK_SEED );
+	return scene;
+}
+
+Result
+makeResult( const char * name, const char * tracing, int numEvaluations )
+{
+	Result result;
+	result.name = name;
+	result.tracing = tracing;
+	result.numEvaluations = numEvaluations;
+	result.raysPerEvaluation = 0.0;
+	return result;
+}
+
+// shades every point SHADING_BENCHMARK_NUM_RUNS times with material
+Result
+shadePoints( const char * name, const char * tracing, const Material & material, const Scene & scene,
+			 std::vector<ShadingPoint>& points )
+{
+	Result result = makeResult( name, tracing, (int)points.size() );
+
+	for( size_t i = 0; i < points.size(); i++ )
+		points[i].hit.material = &material;
+
+	for( int run = 0; run < SHADING_BENCHMARK_NUM_RUNS; run++ )
+	{
+		// bump mapping and the refractor use rand(); every run gets the same numbers
+		srand( SHADING_BENCHMARK_SEED );
+		const RenderStats::Count raysBefore = RenderStats::local().totalRays();
+		float sum = 0.0f;
+		result.timing.start();
+
+		for( size_t i = 0; i < points.size(); i++ )
+		{
+			const Vector3 L = material.shade( points[i].ray, points[i].hit, scene );
+			sum += L.x + L.y + L.z;
+		}
+
+		result.timing.stop();
+		g_sink = sum;
+
+		result.raysPerEvaluation = (double)( RenderStats::local().totalRays() - raysBefore ) / points.size();
+	}
+	return result;
+}
+
+// the functions timed on their own; each takes a point and returns a float
+float perlinNoise( const float p[3] )   {return PerlinNoise::noise( p[0], p[1], p[2] );}
+
+// the same parameters as Stone's noise
+CustomizablePerlinNoise g_customizableNoise( 4, 4, 1, 94 );
+float customizablePerlinNoise( const float p[3] ) {return g_customizableNoise.Get( p[0], p[1], p[2] );}
+
+// the two nearest feature points, as Stone asks for
+float worleyNoise( const float p[3] )
+{
+	float at[3] = {p[0], p[1], p[2]};
+	float F[2];
+	float delta[2][3];
+	unsigned long ID[2];
+	WorleyNoise::noise3D( at, 2, F, delta, ID );
+	return F[1] - F[0];
+}
+
+Result
+timeNoise( const char * name, float (*noise)( const float p[3] ), const std::vector<float>& points )
+{
+	Result result = makeResult( name, "-", (int)( points.size() / 3 ) );
+
+	for( int run = 0; run < SHADING_BENCHMARK_NUM_RUNS; run++ )
+	{
+		float sum = 0.0f;
+		result.timing.start();
+		for( size_t i = 0; i < points.size(); i += 3 )
+			sum += noise( &points[i] );
+		result.timing.stop();
+		g_sink = sum;
+	}
+	return result;
+}
+
+double
+nanosecondsPerEvaluation( const Result & result )
+{
+	return result.numEvaluations > 0 ? result.timing.seconds() / result.numEvaluations * 1e9 : 0.0;
+}
+
+void
+writeResult( BenchmarkWriter & writer, const Result & r )
+{
+	writer.addString( "name", r.name );
+	writer.addString( "tracing", r.tracing );
+	writer.addInt( "evaluations", r.numEvaluations );
+	writer.addDouble( "seconds", r.timing.seconds(), 6 );
+	writer.addDouble( "ns_per_evaluation", nanosecondsPerEvaluation( r ), 2 );
+	writer.addDouble( "rays_per_evaluation", r.raysPerEvaluation, 4 );
+	writer.addCounters( r.timing, r.numEvaluations, "evaluation" );
+	writer.endRow();
+}
+
+} // namespace
+
+
+bool
+ShadingBenchmark::run( const char * filename )
+{
+	// the scene owns the mesh once it's been added
+	TriangleMesh * mesh = new TriangleMesh;
+	if( !BenchmarkUtil::loadMesh( *mesh, MESH_FILE ) )
+	{
+		fprintf( stderr, "Couldn't load %s\n", MESH_FILE );
+		delete mesh;
+		return false;
+	}
+	Vector3 min( MIRO_TMAX ), max( -MIRO_TMAX );
+	for( int i = 0; i < mesh->numTris(); i++ )
+	{
+		const TriangleMesh::TupleI3 & tri = mesh->vIndices()[i];
+		const unsigned int corners[3] = {tri.x, tri.y, tri.z};
+		for( int c = 0; c < 3; c++ )
+		{
+			const Vector3 & v = mesh->vertices()[corners[c]];
+			min = Vector3( std::min( min.x, v.x ), std::min( min.y, v.y ), std::min( min.z, v.z ) );
+			max = Vector3( std::max( max.x, v.x ), std::max( max.y, v.y ), std::max( max.z, v.z ) );
+		}
+	}
+
+	// the hits: anywhere in the mesh's bounds, facing the ray that found them
+	Random random( SHADING_BENCHMARK_SEED );
+	std::vector<ShadingPoint> points( SHADING_BENCHMARK_NUM_HITS );
+	for( size_t i = 0; i < points.size(); i++ )
+	{
+		ShadingPoint & p = points[i];
+		p.hit.P = Vector3( min.x + ( max.x - min.x ) * random.nextFloat(),
+						   min.y + ( max.y - min.y ) * random.nextFloat(),
+						   min.z + ( max.z - min.z ) * random.nextFloat() );
+		p.hit.N = BenchmarkUtil::randomDirection( random );
+		Vector3 d = BenchmarkUtil::randomDirection( random );
+		if( dot( d, p.hit.N ) > 0.0f )
+			d = -d;
+		p.ray = Ray( p.hit.P - d, d );
+		p.hit.t = 1.0f;
+	}
+
+	const Lambert lambert( Vector3( 0.8f ) );
+	const Stone stone( Stone::REALISTIC );
+	const Sand sand;
+	const SpecularReflector reflector( Vector3( 0.9f ) );
+	const SpecularRefractor refractor( SpecularRefractor::getRefractiveIndex( SpecularRefractor::GLASS_COMMON ) );
+
+	const char * names[] = {"Lambert", "Stone", "Sand", "SpecularReflector", "SpecularRefractor"};
+	const Material * materials[] = {&lambert, &stone, &sand, &reflector, &refractor};
+	const int numMaterials = sizeof(materials) / sizeof(materials[0]);
+
+	std::vector<Result> results;
+	for( int tracing = 0; tracing < 2; tracing++ )
+	{
+		const bool real = tracing == 1;
+		Scene * scene = makeScene( min, max, real ? mesh : 0, &lambert );
+		for( int i = 0; i < numMaterials; i++ )
+			results.push_back( shadePoints( names[i], real ? "real" : "stub", *materials[i], *scene, points ) );
+		delete scene;
+	}
+
+	std::vector<float> noisePoints( SHADING_BENCHMARK_NUM_NOISE_POINTS * 3 );
+	for( size_t i = 0; i < noisePoints.size(); i++ )
+		noisePoints[i] = 8.0f * random.nextFloat();
+	results.push_back( timeNoise( "CustomizablePerlinNoise::Get", customizablePerlinNoise, noisePoints ) );
+	results.push_back( timeNoise( "PerlinNoise::noise", perlinNoise, noisePoints ) );
+	results.push_back( timeNoise( "WorleyNoise::noise3D", worleyNoise, noisePoints ) );
+
+	printf( "\n%-30s %8s %12s %10s\n", "", "tracing", "ns/eval", "rays/eval" );
+	for( size_t i = 0; i < results.size(); i++ )
+	{
+		const Result & r = results[i];
+		printf( "%-30s %8s %12.1f %10.2f", r.name, r.tracing, nanosecondsPerEvaluation( r ), r.raysPerEvaluation );
+		if( r.timing.haveCounters() )
+		{
+			printf( "   %.2f IPC, %.2f cache misses/eval, %.2f branch misses/eval", r.timing.counters().ipc(),
+				r.timing.perUnit( PerfCounters::CACHE_MISSES, r.numEvaluations ),
+				r.timing.perUnit( PerfCounters::BRANCH_MISSES, r.numEvaluations ) );
+		}
+		printf( "\n" );
+	}
+
+	BenchmarkWriter writer;
+	if( !writer.open( filename ) )
+		return false;
+	for( size_t i = 0; i < results.size(); i++ )
+		writeResult( writer, results[i] );
+	const bool ok = writer.close();
+
+	if( ok )
+		printf( "\nWrote the results to %s\n", filename );
+	return ok;
+}
@@ -0,0 +1,226 @@
+#include "Socket.h"
+#include "DebugMem.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef WIN32
+#include <ws2tcpip.h>
+#pragma warning(disable:4996)
+typedef int socklen_t;
+#define INVALID_HANDLE INVALID_SOCKET
+#define closeSocket closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <signal.h>
+#define INVALID_HANDLE (-1)
+#define closeSocket ::close
+#endif
+
+namespace
+{
+
+// name must hold at least 22 characters ("255.255.255.255:65535")
+void
+formatPeerName( const sockaddr_in & addr, char * name )
+{
+	const unsigned char * ip = (const unsigned char*)&addr.sin_addr;
+	sprintf( name, "%d.%d.%d.%d:%d", ip[0], ip[1], ip[2], ip[3], ntohs( addr.sin_port ) );
+}
+
+} // namespace
+
+
+bool
+Socket::startup()
+{
+#ifdef WIN32
+	WSADATA data;
+	if( WSAStartup( MAKEWORD( 2, 2 ), &data ) != 0 )
+	{
+		fprintf( stderr, "Couldn't initialize Winsock\n" );
+		return false;
+	}
+#else
+	// a worker that disconnects mid-send would otherwise kill us with SIGPIPE
+	signal( SIGPIPE, SIG_IGN );
+#endif
+	return true;
+}
+
+Socket::Socket() : m_handle(INVALID_HANDLE)
+{
+	m_peer_name[0] = 0;
+}
+
+Socket::~Socket()
+{
+	close();
+}
+
+bool
+Socket::listen( unsigned short port )
+{
+	close();
+
+	m_handle = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if( m_handle == INVALID_HANDLE )
+		return false;
+
+	// so a restarted coordinator can reuse the port right away
+	int reuse = 1;
+	setsockopt( m_handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse) );
+
+	sockaddr_in addr;
+	memset( &addr, 0, sizeof(addr) );
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl( INADDR_ANY );
+	addr.sin_port = htons( port );
+
+	if( bind( m_handle, (sockaddr*)&addr, sizeof(addr) ) != 0 || ::listen( m_handle, SOMAXCONN ) != 0 )
+	{
+		fprintf( stderr, "Couldn't listen on port %d\n", port );
+		close();
+		return false;
+	}
+	return true;
+}
+
+Socket*
+Socket::accept()
+{
+	sockaddr_in addr;
+	socklen_t addrLength = sizeof(addr);
+	SocketHandle handle = ::accept( m_handle, (sockaddr*)&addr, &addrLength );
+	if( handle == INVALID_HANDLE )
+		return 0;
+
+	// tiles are sent as single small messages; don't hold them back
+	int noDelay = 1;
+	setsockopt( handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay) );
+
+	Socket * socket = new Socket;
+	socket->m_handle = handle;
+	formatPeerName( addr, socket->m_peer_name );
+	return socket;
+}
+
+bool
+Socket::connect( const char * host, unsigned short port )
+{
+	close();
+
+	hostent * entry = gethostbyname( host );
+	if( !entry || entry->h_addrtype != AF_INET )
+	{
+		fprintf( stderr, "Couldn't look up host %s\n", host );
+		return false;
+	}
+
+	sockaddr_in addr;
+	memset( &addr, 0, sizeof(addr) );
+	addr.sin_family = AF_INET;
+	memcpy( &addr.sin_addr, entry->h_addr_list[0], sizeof(addr.sin_addr) );
+	addr.sin_port = htons( port );
+
+	m_handle = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if( m_handle == INVALID_HANDLE )
+		return false;
+
+	if( ::connect( m_handle, (sockaddr*)&addr, sizeof(addr) ) != 0 )
+	{
+		fprintf( stderr, "Couldn't connect to %s:%d\n", host, port );
+		close();
+		return false;
+	}
+
+	int noDelay = 1;
+	setsockopt( m_handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay) );
+	formatPeerName( addr, m_peer_name );
+	return true;
+}
+
+void
+Socket::close()
+{
+	if( m_handle != INVALID_HANDLE )
+	{
+		closeSocket( m_handle );
+		m_handle = INVALID_HANDLE;
+	}
+}
+
+bool
+Socket::isOpen() const
+{
+	return m_handle != INVALID_HANDLE;
+}
+
+bool
+Socket::sendAll( const void * data, size_t numBytes )
+{
+	const char * bytes = (const char*)data;
+	while( numBytes > 0 )
+	{
+		const int sent = send( m_handle, bytes, (int)numBytes, 0 );
+		if( sent <= 0 )
+			return false;
+		bytes += sent;
+		numBytes -= sent;
+	}
+	return true;
+}
+
+bool
+Socket::recvAll( void * data, size_t numBytes )
+{
+	char * bytes = (char*)data;
+	while( numBytes > 0 )
+	{
+		const int received = recv( m_handle, bytes, (int)numBytes, 0 );
+		if( received <= 0 )
+			return false;
+		bytes += received;
+		numBytes -= received;
+	}
+	return true;
+}
+
+bool
+Socket::select( const std::vector<Socket*>& sockets, int timeoutMs, std::vector<Socket*>& ready )
+{
+	fd_set readSet;
+	FD_ZERO( &readSet );
+
+	SocketHandle maxHandle = 0;
+	for( size_t i = 0; i < sockets.size(); i++ )
+	{
+		FD_SET( sockets[i]->m_handle, &readSet );
+		if( sockets[i]->m_handle > maxHandle )
+			maxHandle = sockets[i]->m_handle;
+	}
+
+	timeval timeout;
+	timeout.tv_sec = timeoutMs / 1000;
+	timeout.tv_usec = ( timeoutMs % 1000 ) * 1000;
+
+	ready.clear();
+
+	// the first argument is ignored by Winsock
+	const int result = ::select( (int)maxHandle + 1, &readSet, 0, 0, &timeout );
+	if( result < 0 )
+		return false;
+
+	for( size_t i = 0; i < sockets.size(); i++ )
+	{
+		if( FD_ISSET( sockets[i]->m_handle, &readSet ) )
+			ready.push_back( sockets[i] );
+	}
+	return true;
+}
@@ -72,7 +72,7 @@ SpecularReflector::getReflectedColor( const Ray& ray, const HitInfo& hit, const
 
 	HitInfo recursiveHit;
 	Vector3 reflectedLight(0,0,0);
-	if( scene.trace( recursiveHit, reflectedRay, epsilon, MIRO_TMAX ) )
+	if( scene.trace( recursiveHit, reflectedRay, RenderStats::REFLECTION, epsilon, MIRO_TMAX ) )
 		reflectedLight = m_kd * recursiveHit.material->shade( reflectedRay, recursiveHit, scene );
 	else
 	{
@@ -77,7 +77,7 @@ SpecularRefractor::shade(const Ray& ray, const HitInfo& hit,const Scene& scene)
 	{
 		HitInfo recursiveHit;
 		// trace the refracted ray
-		if( scene.trace( recursiveHit, refractedRay, epsilon, MIRO_TMAX ) )
+		if( scene.trace( recursiveHit, refractedRay, RenderStats::REFRACTION, epsilon, MIRO_TMAX ) )
 		{
 			// use Beer's law: http://www.flipcode.com/archives/Raytracing_Topics_Techniques-Part_3_Refractions_and_Beers_Law.shtml
 			float rayLength = ( recursiveHit.P - refractedRay.o ).length();
@@ -64,3 +64,10 @@ Sphere::intersect(HitInfo& result, const Ray& ray,
 
     return true;
 }
+
+void
+Sphere::getBounds(Vector3& vMin, Vector3& vMax) const
+{
+    vMin = m_center - Vector3(m_radius);
+    vMax = m_center + Vector3(m_radius);
+}
@@ -0,0 +1,26 @@
+#include "Timer.h"
+#include "DebugMem.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+double
+Timer::now()
+{
+#ifdef WIN32
+	static LARGE_INTEGER frequency = {0};
+	if( frequency.QuadPart == 0 )
+		QueryPerformanceFrequency( &frequency );
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	timespec t;
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
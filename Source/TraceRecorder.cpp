@@ -0,0 +1,147 @@
+#include "TraceRecorder.h"
+#include "Timer.h"
+#include "DebugMem.h"
+#include <stdio.h>
+
+#ifdef WIN32
+// disable useless warnings
+#pragma warning(disable:4996)
+#endif
+
+bool TraceRecorder::s_enabled = false;
+double TraceRecorder::s_origin = 0.0;
+THREAD_LOCAL TraceRecorder::ThreadBuffer * TraceRecorder::s_buffer = 0;
+std::vector<TraceRecorder::ThreadBuffer*> TraceRecorder::s_buffers;
+std::vector<std::string> TraceRecorder::s_lane_names;
+SpinLock TraceRecorder::s_lock;
+
+void
+TraceRecorder::enable()
+{
+	if( !USE_TRACING )
+		return;
+
+	s_origin = Timer::now();
+	s_enabled = true;
+}
+
+int
+TraceRecorder::newLane( const std::string & name )
+{
+	s_lock.lock();
+	const int lane = (int)s_lane_names.size();
+	s_lane_names.push_back( name );
+	s_lock.unlock();
+
+	return lane;
+}
+
+int
+TraceRecorder::threadLane()
+{
+	if( !s_buffer )
+	{
+		// the buffers are freed with the process; a thread's events have to outlive it until write()
+		ThreadBuffer * buffer = new ThreadBuffer;
+
+		s_lock.lock();
+		char name[32];
+		if( s_buffers.empty() )
+			sprintf( name, "main thread" );
+		else
+			sprintf( name, "thread %d", (int)s_buffers.size() );
+		buffer->lane = (int)s_lane_names.size();
+		s_lane_names.push_back( name );
+		s_buffers.push_back( buffer );
+		s_lock.unlock();
+
+		s_buffer = buffer;
+	}
+	return s_buffer->lane;
+}
+
+void
+TraceRecorder::record( char type, int lane, const char * name, const char * category, double start, double duration,
+	double value, const char * arg0Name, int arg0, const char * arg1Name, int arg1 )
+{
+	threadLane(); // makes the calling thread's buffer if it doesn't have one yet
+
+	Event e;
+	e.type = type;
+	e.lane = lane;
+	e.name = name;
+	e.category = category;
+	e.start = start - s_origin;
+	e.duration = duration;
+	e.value = value;
+	e.argNames[0] = arg0Name;
+	e.args[0] = arg0;
+	e.argNames[1] = arg1Name;
+	e.args[1] = arg1;
+	s_buffer->events.push_back( e );
+}
+
+bool
+TraceRecorder::write( const char * filename )
+{
+	if( !isEnabled() )
+		return false;
+
+	FILE * fp = fopen( filename, "w" );
+	if( !fp )
+	{
+		fprintf( stderr, "Couldn't open trace file %s for writing\n", filename );
+		return false;
+	}
+
+	// other threads must be done recording by now, so the buffers can be read without them
+	s_lock.lock();
+
+	fprintf( fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n" );
+	fprintf( fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"miro\"}}" );
+	for( size_t i = 0; i < s_lane_names.size(); i++ )
+	{
+		fprintf( fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+			(int)i, s_lane_names[i].c_str() );
+		// keep the lanes in the order they were made
+		fprintf( fp, ",\n{\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+			(int)i, (int)i );
+	}
+
+	int numEvents = 0;
+	for( size_t i = 0; i < s_buffers.size(); i++ )
+	{
+		std::vector<Event>& events = s_buffers[i]->events;
+		for( size_t j = 0; j < events.size(); j++ )
+		{
+			const Event& e = events[j];
+			// Chrome traces count in microseconds
+			fprintf( fp, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f",
+				e.name, e.category, e.type, e.lane, e.start * 1e6 );
+			if( e.type == 'C' )
+			{
+				fprintf( fp, ", \"args\": {\"%s\": %.3f}}", e.name, e.value );
+			}
+			else
+			{
+				fprintf( fp, ", \"dur\": %.3f, \"args\": {", e.duration * 1e6 );
+				if( e.argNames[0] )
+					fprintf( fp, "\"%s\": %d", e.argNames[0], e.args[0] );
+				if( e.argNames[1] )
+					fprintf( fp, "%s\"%s\": %d", e.argNames[0] ? ", " : "", e.argNames[1], e.args[1] );
+				fprintf( fp, "}}" );
+			}
+			numEvents++;
+		}
+		events.clear();
+	}
+	fprintf( fp, "\n]}\n" );
+
+	s_lock.unlock();
+
+	const bool ok = !ferror( fp );
+	fclose( fp );
+	if( ok )
+		printf( "Wrote %d trace events to %s\n", numEvents, filename );
+	return ok;
+}
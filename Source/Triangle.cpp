@@ -2,7 +2,7 @@
 #include "TriangleMesh.h"
 #include "Matrix3x3.h"
 #include "Ray.h"
-#include "BVH.h"
+#include "RenderStats.h"
 #include "DebugMem.h"
 
 Triangle::Triangle(TriangleMesh * m, unsigned int i) :
@@ -43,17 +43,27 @@ Triangle::renderGL()
 bool
 Triangle::intersect(HitInfo& result, const Ray& r,float tMin, float tMax)
 {
-	BVH::intersectPrimitive();
+	if( !intersect( result, r, m_mesh, m_index, tMin, tMax ) )
+		return false;
 
-	TriangleMesh::TupleI3 ti3Vertices = m_mesh->vIndices()[m_index];
-	const Vector3 & ptA = m_mesh->vertices()[ti3Vertices.x]; //vertex a of triangle
-	const Vector3 & ptB = m_mesh->vertices()[ti3Vertices.y]; //vertex b of triangle
-	const Vector3 & ptC = m_mesh->vertices()[ti3Vertices.z]; //vertex c of triangle
+	result.material = this->m_material;
+	return true;
+}
+
+bool
+Triangle::intersect(HitInfo& result, const Ray& r, TriangleMesh* mesh, unsigned int i, float tMin, float tMax)
+{
+	RenderStats::countPrimitiveTest();
+
+	TriangleMesh::TupleI3 ti3Vertices = mesh->vIndices()[i];
+	const Vector3 & ptA = mesh->vertices()[ti3Vertices.x]; //vertex a of triangle
+	const Vector3 & ptB = mesh->vertices()[ti3Vertices.y]; //vertex b of triangle
+	const Vector3 & ptC = mesh->vertices()[ti3Vertices.z]; //vertex c of triangle
 
-	TriangleMesh::TupleI3 ti3Normals = m_mesh->nIndices()[m_index];
-	const Vector3 & normalPtA = m_mesh->normals()[ti3Normals.x]; //vertex a normal of triangle
-	const Vector3 & normalPtB = m_mesh->normals()[ti3Normals.y]; //vertex b normal of triangle
-	const Vector3 & normalPtC = m_mesh->normals()[ti3Normals.z]; //vertex c normal of triangle
+	TriangleMesh::TupleI3 ti3Normals = mesh->nIndices()[i];
+	const Vector3 & normalPtA = mesh->normals()[ti3Normals.x]; //vertex a normal of triangle
+	const Vector3 & normalPtB = mesh->normals()[ti3Normals.y]; //vertex b normal of triangle
+	const Vector3 & normalPtC = mesh->normals()[ti3Normals.z]; //vertex c normal of triangle
 
 	// compute intersection with Plucker coordinates, with help from http://pelopas.uop.gr/~nplatis/files/PlatisTheoharisRayTetra.pdf
 	if( USE_PLUCKER_COORDS ) 
@@ -106,7 +116,6 @@ Triangle::intersect(HitInfo& result, const Ray& r,float tMin, float tMax)
 			result.N = alpha*normalPtA + beta*normalPtB + gamma*normalPtC;
 			// normalize the result's normal vector
 			result.N.normalize();
-			result.material = this->m_material;
 
 			return true;
 		}
@@ -139,7 +148,6 @@ Triangle::intersect(HitInfo& result, const Ray& r,float tMin, float tMax)
 			result.N = (alpha * normalPtA) + (beta * normalPtB) + (gamma * normalPtC);
 			// normalize the result's normal vector
 			result.N.normalize();
-			result.material = this->m_material;
 			
 			return true;
 		}
@@ -163,12 +171,40 @@ Triangle::permutedInnerProduct(Vector3 pluckerR[2], Vector3 pluckerS[2])
 	return dot(pluckerR[0], pluckerS[1]) + dot(pluckerR[1], pluckerS[0]);
 }
 
+void
+Triangle::getBounds(Vector3& vMin, Vector3& vMax) const
+{
+	getBounds( m_mesh, m_index, vMin, vMax );
+}
+
+Vector3
+Triangle::getMidPoint() const
+{
+	return getMidPoint( m_mesh, m_index );
+}
+
+void
+Triangle::getBounds(TriangleMesh* mesh, unsigned int i, Vector3& vMin, Vector3& vMax)
+{
+	TriangleMesh::TupleI3 ti3Vertices = mesh->vIndices()[i];
+	const Vector3 & ptA = mesh->vertices()[ti3Vertices.x]; //vertex a of triangle
+	const Vector3 & ptB = mesh->vertices()[ti3Vertices.y]; //vertex b of triangle
+	const Vector3 & ptC = mesh->vertices()[ti3Vertices.z]; //vertex c of triangle
+
+	vMin.x = std::min( ptA.x, std::min( ptB.x, ptC.x ) );
+	vMin.y = std::min( ptA.y, std::min( ptB.y, ptC.y ) );
+	vMin.z = std::min( ptA.z, std::min( ptB.z, ptC.z ) );
+	vMax.x = std::max( ptA.x, std::max( ptB.x, ptC.x ) );
+	vMax.y = std::max( ptA.y, std::max( ptB.y, ptC.y ) );
+	vMax.z = std::max( ptA.z, std::max( ptB.z, ptC.z ) );
+}
+
 Vector3
-Triangle::getMidPoint()
+Triangle::getMidPoint(TriangleMesh* mesh, unsigned int i)
 {
-	TriangleMesh::TupleI3 ti3Vertices = m_mesh->vIndices()[m_index];
-	const Vector3 & ptA = m_mesh->vertices()[ti3Vertices.x]; //vertex a of triangle
-	const Vector3 & ptB = m_mesh->vertices()[ti3Vertices.y]; //vertex b of triangle
-	const Vector3 & ptC = m_mesh->vertices()[ti3Vertices.z]; //vertex c of triangle
+	TriangleMesh::TupleI3 ti3Vertices = mesh->vIndices()[i];
+	const Vector3 & ptA = mesh->vertices()[ti3Vertices.x]; //vertex a of triangle
+	const Vector3 & ptB = mesh->vertices()[ti3Vertices.y]; //vertex b of triangle
+	const Vector3 & ptC = mesh->vertices()[ti3Vertices.z]; //vertex c of triangle
 	return ( ptA + ptB + ptC ) / 3;
 }
\ No newline at end of file
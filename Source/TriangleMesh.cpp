@@ -1,34 +1,41 @@
 #include "TriangleMesh.h"
 #include "Triangle.h"
 #include "Scene.h"
+#include "BVH.h"
+#include "MemoryStats.h"
 #include "DebugMem.h"
 
 TriangleMesh::TriangleMesh() :
-	m_materials(0),
+	m_materialIndices(0),
+	m_materialTable(1, (const Material*)0),
     m_normals(0),
     m_vertices(0),
     m_texCoords(0),
     m_normalIndices(0),
     m_vertexIndices(0),
-    m_texCoordIndices(0)
+    m_texCoordIndices(0),
+    m_numTris(0),
+    m_vertexBytes(0),
+    m_normalBytes(0),
+    m_indexBytes(0),
+    m_bvh(0)
 {
 
 }
 
 TriangleMesh::~TriangleMesh()
 {
-	if( m_materials )
+	if( m_bvh )
 	{
-		for( unsigned int i = 0; i < m_numTris; i++ )
-		{
-			if( m_materials[i] )
-			{
-				delete m_materials[i];
-				m_materials = NULL;
-			}
-		}
-		delete [] m_materials;
-		m_materials = NULL;
+		delete m_bvh;
+		m_bvh = NULL;
+	}
+
+	if( m_materialIndices )
+	{
+		// the materials themselves are shared and owned by the MaterialLibrary
+		delete [] m_materialIndices;
+		m_materialIndices = NULL;
 	}
 
 	if( m_normals )
@@ -66,4 +73,47 @@ TriangleMesh::~TriangleMesh()
 		delete [] m_texCoordIndices;
 		m_texCoordIndices = NULL;
 	}
+
+	MemoryStats::remove( MemoryStats::MESH_VERTICES, m_vertexBytes );
+	MemoryStats::remove( MemoryStats::MESH_NORMALS, m_normalBytes );
+	MemoryStats::remove( MemoryStats::MESH_INDICES, m_indexBytes );
+}
+
+void
+TriangleMesh::countArrays(size_t numVertices, size_t numNormals, size_t numTexCoords, size_t numFaces, bool materialIndices)
+{
+	m_vertexBytes = numVertices * sizeof(Vector3) + numTexCoords * sizeof(VectorR2);
+	m_normalBytes = numNormals * sizeof(Vector3);
+	// vertex and normal indices always, texture coordinate indices if there are texture coordinates
+	m_indexBytes = numFaces * sizeof(TupleI3) * ( numTexCoords ? 3 : 2 ) + ( materialIndices ? numFaces * sizeof(unsigned short) : 0 );
+
+	MemoryStats::add( MemoryStats::MESH_VERTICES, m_vertexBytes );
+	MemoryStats::add( MemoryStats::MESH_NORMALS, m_normalBytes );
+	MemoryStats::add( MemoryStats::MESH_INDICES, m_indexBytes );
+}
+
+void
+TriangleMesh::renderGL()
+{
+	glBegin(GL_TRIANGLES);
+	for (unsigned int i = 0; i < m_numTris; ++i)
+	{
+		TupleI3 ti3 = m_vertexIndices[i];
+		glVertex3f(m_vertices[ti3.x].x, m_vertices[ti3.x].y, m_vertices[ti3.x].z);
+		glVertex3f(m_vertices[ti3.y].x, m_vertices[ti3.y].y, m_vertices[ti3.y].z);
+		glVertex3f(m_vertices[ti3.z].x, m_vertices[ti3.z].y, m_vertices[ti3.z].z);
+	}
+	glEnd();
+}
+
+void
+TriangleMesh::buildBVH(const Material * material)
+{
+	// the BVH addresses our triangles directly, so no Triangle objects are needed
+	if( !m_materialTable[0] )
+		setMaterial( material );
+
+	TriangleMeshes meshes( 1, this );
+	m_bvh = new BVH;
+	m_bvh->build( NULL, &meshes );
 }
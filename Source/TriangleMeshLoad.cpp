@@ -1,8 +1,11 @@
 #include "TriangleMesh.h"
 #include "Console.h"
+#include "Profiler.h"
 #include "DebugMem.h"
 #include "Material.h"
 #include "Lambert.h"
+#include "MaterialLibrary.h"
+#include <string.h>
 
 #ifdef WIN32
 // disable useless warnings
@@ -41,6 +44,7 @@ TriangleMesh::createSingleTriangle()
     m_texCoordIndices[0].z = 2;
 
     m_numTris = 1;
+    countArrays(3, 3, 3, 1, false);
 }
 
 //************************************************************************
@@ -51,7 +55,9 @@ TriangleMesh::createSingleTriangle()
 bool
 TriangleMesh::load(char* file, const Matrix4x4& ctm)
 {
-    FILE *fp = fopen(file, "rb");
+    PROFILE_SCOPE(OBJ_PARSE);
+
+    FILE *fp = openAsset(file, "rb");
     if (!fp)
     {
         error("Cannot open \"%s\" for reading\n",file);
@@ -133,9 +139,8 @@ TriangleMesh::loadObj(FILE* fp, const Matrix4x4& ctm)
     }
     m_normalIndices = new TupleI3[nf]; // always make normals
     m_vertexIndices = new TupleI3[nf]; // always have vertices
-	m_materials = new Material*[nf];
-	for( int i = 0; i < nf; i++ )
-		m_materials[i] = NULL;
+	m_materialIndices = new unsigned short[nf];
+    countArrays(nv, std::max(nv,nf), nt, nf, true);
 
     m_numTris = 0;
     int nvertices = 0;
@@ -146,7 +151,7 @@ TriangleMesh::loadObj(FILE* fp, const Matrix4x4& ctm)
     nctm.invert();
     nctm.transpose();
 
-	Material * material = NULL;
+	unsigned short materialIndex = 0; // faces use the mesh's default material until we see a usemtl
 
     while (fgets(line, 80, fp) != 0)
     {
@@ -168,7 +173,23 @@ TriangleMesh::loadObj(FILE* fp, const Matrix4x4& ctm)
 			if( carriageReturn )
 				*carriageReturn = '\0';
 
-			material = Material::loadMaterial( materialFileName );
+			const Material * material = MaterialLibrary::getMaterial( materialFileName );
+			materialIndex = 0;
+			if( material )
+			{
+				// reuse this material's table entry if an earlier usemtl already added it
+				for( unsigned int i = 1; i < m_materialTable.size(); i++ )
+				{
+					if( m_materialTable[i] == material )
+						materialIndex = ( unsigned short )i;
+				}
+
+				if( !materialIndex )
+				{
+					materialIndex = ( unsigned short )m_materialTable.size();
+					m_materialTable.push_back( material );
+				}
+			}
 		}
         else if (line[0] == 'v')
         {
@@ -237,9 +258,7 @@ TriangleMesh::loadObj(FILE* fp, const Matrix4x4& ctm)
                 nn++;
             }
 
-			// if there's a material, add it to this face
-			if( material )
-				m_materials[m_numTris] = material;
+			m_materialIndices[m_numTris] = materialIndex;
 
             m_numTris++;
         } //  else ignore line
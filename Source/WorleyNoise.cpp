@@ -308,7 +308,8 @@ addSamples(long xi, long maxOrder, float at, float *F, float(*delta), unsigned l
 {
     float dx, fx, d2;
     long count, i, j, index;
-    unsigned long seed, this_id;
+    unsigned int seed; // the hashes below assume 32 bits, which a long isn't everywhere
+    unsigned long this_id;
 
     // Each cube has a random number seed based on the cube's ID number.
     // The seed might be better if it were a nonlinear hash like Perlin uses
@@ -369,7 +370,8 @@ addSamples(long xi, long yi, long maxOrder,
 {
     float dx, dy, fx, fy, d2;
     long count, i, j, index;
-    unsigned long seed, this_id;
+    unsigned int seed; // the hashes below assume 32 bits, which a long isn't everywhere
+    unsigned long this_id;
 
     // Each cube has a random number seed based on the cube's ID number.
     // The seed might be better if it were a nonlinear hash like Perlin uses
@@ -435,7 +437,8 @@ addSamples(long xi, long yi, long zi, long maxOrder,
 {
     float dx, dy, dz, fx, fy, fz, d2;
     long count, i, j, index;
-    unsigned long seed, this_id;
+    unsigned int seed; // the hashes below assume 32 bits, which a long isn't everywhere
+    unsigned long this_id;
 
     // Each cube has a random number seed based on the cube's ID number.
     // The seed might be better if it were a nonlinear hash like Perlin uses
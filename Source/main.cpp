@@ -13,6 +13,16 @@
 #include "Lambert.h"
 #include "MiroWindow.h"
 #include "Matrix3x3.h"
+#include "RenderOptions.h"
+#include "MaterialLibrary.h"
+#include "DistributedRenderer.h"
+#include "Profiler.h"
+#include "PerfCounters.h"
+#include "TraceRecorder.h"
+#include "Benchmark.h"
+#include "ShadingBenchmark.h"
+#include "Regression.h"
+#include "BVHAnalysis.h"
 
 #include "DebugMem.h"
 #include "Assignment0.h"
@@ -28,6 +38,24 @@
 int
 main(int argc, char*argv[])
 {
+	if( !g_options.parse( &argc, argv ) )
+		return 1;
+
+	// before the benchmarks, which count too
+	if( g_options.perfCounters )
+		PerfCounters::enable();
+
+	if( g_options.benchmarkFile )
+		return Benchmark::run( g_options.benchmarkFile ) ? 0 : 1;
+	if( g_options.shadingBenchmarkFile )
+		return ShadingBenchmark::run( g_options.shadingBenchmarkFile ) ? 0 : 1;
+	if( g_options.regressDirectory )
+		return Regression::run( g_options.regressDirectory, g_options.regressUpdate, g_options.regressTolerance ) ? 0 : 1;
+
+	// trace from here so the scene load is on the timeline
+	if( g_options.traceFile )
+		TraceRecorder::enable();
+
     // create a scene
 
 	Assignment0 *assn0;
@@ -36,75 +64,114 @@ main(int argc, char*argv[])
 	Assignment3 *assn3;
 	Assignment4 *assn4;
 
-	switch( ASSIGNMENT_NUMBER )
 	{
-	case 0:
-		// ASSIGNMENT 0
-		assn0 = new Assignment0();
-		assn0->makeSpiralScene();
-		//assn0->makeSpirographScene();
-		delete assn0;
-		assn0 = NULL;
-		break;
-
-	case 1:
-		// ASSIGNMENT 1
-		assn1 = new Assignment1();
-		assn1->makeSimpleTriangleScene();
-		delete assn1;
-		assn1 = NULL;
-		break;
-
-	case 2:
-		// ASSIGNMENT 2
-		assn2 = new Assignment2();
-		assn2->makeSponzaScene();
-		delete assn2;
-		assn2 = NULL;
-		break;
-
-	case 3:
-		// ASSIGNMENT 3
-		assn3 = new Assignment3();
-		//assn3->makeCornellScene();
-		assn3->makeTeapotScene(Material::DIFFUSE);
-		delete assn3;
-		assn3 = NULL;
-		break;
-
-	case 4:
-		// ASSIGNMENT 4
-		assn4 = new Assignment4();
-		assn4->makePondScene();
-		delete assn4;
-		assn4 = NULL;
-		break;
+		PROFILE_SCOPE(SCENE_LOAD);
+		switch( ASSIGNMENT_NUMBER )
+		{
+		case 0:
+			// ASSIGNMENT 0
+			assn0 = new Assignment0();
+			assn0->makeSpiralScene();
+			//assn0->makeSpirographScene();
+			delete assn0;
+			assn0 = NULL;
+			break;
+
+		case 1:
+			// ASSIGNMENT 1
+			assn1 = new Assignment1();
+			assn1->makeSimpleTriangleScene();
+			delete assn1;
+			assn1 = NULL;
+			break;
+
+		case 2:
+			// ASSIGNMENT 2
+			assn2 = new Assignment2();
+			assn2->makeSponzaScene();
+			delete assn2;
+			assn2 = NULL;
+			break;
+
+		case 3:
+			// ASSIGNMENT 3
+			assn3 = new Assignment3();
+			//assn3->makeCornellScene();
+			assn3->makeTeapotScene(Material::DIFFUSE);
+			delete assn3;
+			assn3 = NULL;
+			break;
+
+		case 4:
+			// ASSIGNMENT 4
+			assn4 = new Assignment4();
+			assn4->makePondScene();
+			delete assn4;
+			assn4 = NULL;
+			break;
 		
-	default:
-		printf( "ERROR: Don't know how to build assignment %d!!!\n\n", ASSIGNMENT_NUMBER );
-		// make an empty scene so we don't get a seg fault
-		g_camera = new Camera;
-		g_scene = new Scene;
-		g_image = new Image;
-
-		g_image->resize(512, 512);
+		default:
+			printf( "ERROR: Don't know how to build assignment %d!!!\n\n", ASSIGNMENT_NUMBER );
+			// make an empty scene so we don't get a seg fault
+			g_camera = new Camera;
+			g_scene = new Scene;
+			g_image = new Image;
+
+			g_image->resize(512, 512);
 	    
-		// set up the camera
-		g_camera->setBGColor(Vector3(0.0f, 0.0f, 0.2f));
-		g_camera->setEye(Vector3(0, 3, 6));
-		g_camera->setLookAt(Vector3(0, 0, 0));
-		g_camera->setUp(Vector3(0, 1, 0));
-		g_camera->setFOV(45);
-
-		// create and place a point light source
-		PointLight * light = new PointLight;
-		light->setPosition(Vector3(10, 10, 10));
-		light->setColor(Vector3(1, 1, 1));
-		light->setWattage(700);
-		g_scene->addLight(light);
-
-		// let objects do pre-calculations if needed
-		g_scene->preCalc();
+			// set up the camera
+			g_camera->setBGColor(Vector3(0.0f, 0.0f, 0.2f));
+			g_camera->setEye(Vector3(0, 3, 6));
+			g_camera->setLookAt(Vector3(0, 0, 0));
+			g_camera->setUp(Vector3(0, 1, 0));
+			g_camera->setFOV(45);
+
+			// create and place a point light source
+			PointLight * light = new PointLight;
+			light->setPosition(Vector3(10, 10, 10));
+			light->setColor(Vector3(1, 1, 1));
+			light->setWattage(700);
+			g_scene->addLight(light);
+
+			// let objects do pre-calculations if needed
+			g_scene->preCalc();
+		}
+	}
+
+	if( g_options.bvhAnalysisFile )
+	{
+		BVHAnalysis analysis( g_scene->bvh() );
+		analysis.print();
+		if( analysis.exportOBJ( g_options.bvhAnalysisFile ) )
+			printf( "Wrote the BVH's boxes to %s\n", g_options.bvhAnalysisFile );
+	}
+
+	// -crop renders only part of the image
+	if( g_options.cropWidth > 0 &&
+		!g_scene->setCropWindow( g_options.cropX, g_options.cropY, g_options.cropWidth, g_options.cropHeight, g_image ) )
+		return 1;
+
+	if( g_options.headless || g_options.workerHost )
+	{
+		int exitCode = 0;
+
+		// no window: ray trace once (raytraceImage writes the output file), or render
+		// tiles for a coordinator, and quit
+		g_image->clear( g_camera->bgColor() );
+		if( g_options.workerHost )
+			exitCode = DistributedRenderer::work( g_options.workerHost, g_options.workerPort, g_camera, g_image, g_scene );
+		else
+			g_scene->raytraceImage( g_camera, g_image );
+
+		delete g_scene;
+		g_scene = NULL;
+		delete g_camera;
+		g_camera = NULL;
+		delete g_image;
+		g_image = NULL;
+		MaterialLibrary::clear();
+
+		return exitCode;
 	}
 
     MiroWindow miro(&argc, argv);